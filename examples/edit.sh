@@ -1,12 +1,6 @@
 #!/bin/sh
-FILE="$PWD"
-
-while [ -d "$FILE" ]
-do
-    FILE=$FILE/`(echo ..; /bin/ls -p "$FILE") |
-        sprinter -t"Edit file" -l"EDIT:" -g 400,300` ||
-            exit 1
-done
+FILE=`sprinter --walk "$PWD" -t"Edit file" -l"EDIT:" -g 400,300` ||
+    exit 1
 
 gvim "$FILE"|| gedit "$FILE"
 
@@ -0,0 +1,15 @@
+#!/bin/sh
+# Compares latency of typing a query with wildcard and regular expression filter.
+# usage: regex-benchmark.sh [COUNT] [KEYS_SCRIPT] [SPRINTER_OPTIONS...]
+set -e
+count=${1:-1000000}
+keys=${2:-$(dirname "$0")/replay-keys.txt}
+[ $# -gt 0 ] && shift
+[ $# -gt 0 ] && shift
+
+benchmark=$(dirname "$0")/replay-benchmark.sh
+
+echo "wildcard:" >&2
+"$benchmark" "$count" "$keys" "$@"
+echo "regex:" >&2
+"$benchmark" "$count" "$keys" --regex "$@"
@@ -0,0 +1,17 @@
+#!/bin/sh
+# Measures latency from key to frame while typing a recorded query.
+# usage: replay-benchmark.sh [COUNT] [KEYS_SCRIPT] [SPRINTER_OPTIONS...]
+set -e
+count=${1:-2000000}
+keys=${2:-$(dirname "$0")/replay-keys.txt}
+[ $# -gt 0 ] && shift
+[ $# -gt 0 ] && shift
+
+export QT_QPA_PLATFORM=${QT_QPA_PLATFORM:-offscreen}
+export SPRINTER_REPLAY=$keys
+
+# same items in each run
+awk -v count="$count" 'BEGIN {
+    for (i = 0; i < count; ++i)
+        printf "host-%07d.dc%d.example.com\track-%03d\n", i, i % 7, i % 997
+}' | "${SPRINTER:-sprinter}" "$@" > /dev/null
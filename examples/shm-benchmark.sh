@@ -0,0 +1,14 @@
+#!/bin/sh
+# Compares reading items from pipe and from shared memory.
+# usage: shm-benchmark.sh [COUNT] [SPRINTER_OPTIONS...]
+set -e
+count=${1:-5000000}
+[ $# -gt 0 ] && shift
+
+producer=$(mktemp)
+trap 'rm -f "$producer"' EXIT
+cc -O2 -o "$producer" "$(dirname "$0")/shm-producer.c"
+
+export QT_QPA_PLATFORM=${QT_QPA_PLATFORM:-offscreen}
+"$producer" --benchmark --pipe "$count" "$@"
+"$producer" --benchmark "$count" "$@"
@@ -0,0 +1,253 @@
+/*
+ * Reference producer passing items to sprinter using shared memory.
+ *
+ * Generates COUNT host entries and runs sprinter with given options
+ * reading the items from shared memory (or from pipe with --pipe).
+ *
+ * With --benchmark, prints time until sprinter read all items (in both
+ * modes) and stops it.
+ *
+ * usage: shm-producer [--pipe] [--benchmark] COUNT [SPRINTER_OPTIONS...]
+ *
+ * Sprinter executable can be set with SPRINTER environment variable.
+ */
+#define _GNU_SOURCE
+
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+/* see src/sharedinput.h */
+struct header {
+    char magic[8];
+    uint64_t end;
+    uint64_t consumed;
+    uint32_t closed;
+};
+
+static const uint64_t header_size = 64;
+
+/* items added before notifying sprinter */
+static const int batch_size = 4096;
+
+static double now(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void die(const char *what)
+{
+    perror(what);
+    exit(1);
+}
+
+static int item(char *buffer, size_t size, long i)
+{
+    return snprintf(buffer, size, "host-%07ld.dc%ld.example.com\track-%03ld\t10.%ld.%ld.%ld",
+                    i, i % 7, i % 997, (i >> 16) & 255, (i >> 8) & 255, i & 255);
+}
+
+static pid_t run(char **argv, int argc, const char *extra, int stdin_fd)
+{
+    const char *sprinter = getenv("SPRINTER");
+    char **args = calloc(argc + 4, sizeof(char *));
+    int n = 0;
+    int i;
+    pid_t pid;
+
+    args[n++] = (char *)(sprinter ? sprinter : "sprinter");
+    if (extra) {
+        args[n++] = (char *)"--shared-memory";
+        args[n++] = (char *)extra;
+    }
+    for (i = 0; i < argc; ++i)
+        args[n++] = argv[i];
+    args[n] = NULL;
+
+    pid = fork();
+    if (pid == -1)
+        die("fork");
+
+    if (pid == 0) {
+        if (stdin_fd != -1) {
+            dup2(stdin_fd, STDIN_FILENO);
+            close(stdin_fd);
+        }
+        execvp(args[0], args);
+        die("exec");
+    }
+
+    free(args);
+    return pid;
+}
+
+static void report(const char *mode, long count, uint64_t bytes, double seconds)
+{
+    fprintf(stderr, "%-6s %ld items, %.1f MB in %.3f s (%.1f MB/s, %.0f items/s)\n",
+            mode, count, bytes / 1e6, seconds, bytes / 1e6 / seconds, count / seconds);
+}
+
+static pid_t produce_pipe(long count, char **argv, int argc, int benchmark)
+{
+    char line[128];
+    int fds[2];
+    uint64_t bytes = 0;
+    double start;
+    FILE *out;
+    long i;
+    pid_t pid;
+
+    /* write end must not be inherited */
+    if (pipe2(fds, O_CLOEXEC) != 0)
+        die("pipe");
+
+    pid = run(argv, argc, NULL, fds[0]);
+    close(fds[0]);
+
+    out = fdopen(fds[1], "w");
+    if (!out)
+        die("fdopen");
+
+    start = now();
+    for (i = 0; i < count; ++i) {
+        const int size = item(line, sizeof(line), i);
+        line[size] = '\n';
+        fwrite(line, 1, size + 1, out);
+        bytes += size + 1;
+    }
+    fflush(out);
+
+    if (benchmark) {
+        /* same end point as with shared memory: wait until sprinter read everything */
+        int pending;
+        while (ioctl(fileno(out), FIONREAD, &pending) == 0 && pending > 0)
+            usleep(1000);
+        report("pipe", count, bytes, now() - start);
+    }
+
+    fclose(out);
+
+    return pid;
+}
+
+static pid_t produce_shm(long count, char **argv, int argc, int benchmark)
+{
+    char line[128];
+    char fds[64];
+    uint64_t capacity = header_size;
+    uint64_t end = header_size;
+    struct header *header;
+    double start;
+    char *data;
+    int memfd;
+    int eventfd_;
+    long i;
+    pid_t pid;
+
+    for (i = 0; i < count; ++i)
+        capacity += sizeof(uint32_t) + item(line, sizeof(line), i);
+
+    /* memory is allocated only when written */
+    memfd = memfd_create("sprinter-items", 0);
+    if (memfd == -1)
+        die("memfd_create");
+    if (ftruncate(memfd, capacity) != 0)
+        die("ftruncate");
+
+    data = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, memfd, 0);
+    if (data == MAP_FAILED)
+        die("mmap");
+
+    header = (struct header *)data;
+    memcpy(header->magic, "SPRSHM1", 8);
+
+    eventfd_ = eventfd(0, 0);
+    if (eventfd_ == -1)
+        die("eventfd");
+
+    snprintf(fds, sizeof(fds), "%d,%d", memfd, eventfd_);
+    pid = run(argv, argc, fds, -1);
+    close(memfd);
+
+    start = now();
+    for (i = 0; i < count; ++i) {
+        const uint32_t size = item(line, sizeof(line), i);
+        memcpy(data + end, &size, sizeof(size));
+        memcpy(data + end + sizeof(size), line, size);
+        end += sizeof(size) + size;
+
+        if ((i + 1) % batch_size == 0 || i + 1 == count) {
+            const uint64_t one = 1;
+            __atomic_store_n(&header->end, end, __ATOMIC_RELEASE);
+            if (write(eventfd_, &one, sizeof(one)) != sizeof(one))
+                die("write");
+        }
+    }
+
+    {
+        const uint64_t one = 1;
+        __atomic_store_n(&header->closed, 1, __ATOMIC_RELEASE);
+        if (write(eventfd_, &one, sizeof(one)) != sizeof(one))
+            die("write");
+    }
+    close(eventfd_);
+
+    if (benchmark) {
+        while (__atomic_load_n(&header->consumed, __ATOMIC_ACQUIRE) < end)
+            usleep(1000);
+        report("shm", count, end - header_size, now() - start);
+    }
+
+    return pid;
+}
+
+int main(int argc, char **argv)
+{
+    int use_pipe = 0;
+    int benchmark = 0;
+    int status = 0;
+    long count;
+    pid_t pid;
+
+    ++argv;
+    --argc;
+    for ( ; argc > 0 && strncmp(argv[0], "--", 2) == 0; ++argv, --argc) {
+        if (strcmp(argv[0], "--pipe") == 0)
+            use_pipe = 1;
+        else if (strcmp(argv[0], "--benchmark") == 0)
+            benchmark = 1;
+        else
+            break;
+    }
+
+    if (argc < 1 || (count = atol(argv[0])) <= 0) {
+        fprintf(stderr, "usage: shm-producer [--pipe] [--benchmark] COUNT [SPRINTER_OPTIONS...]\n");
+        return 2;
+    }
+
+    pid = use_pipe
+        ? produce_pipe(count, argv + 1, argc - 1, benchmark)
+        : produce_shm(count, argv + 1, argc - 1, benchmark);
+
+    if (benchmark)
+        kill(pid, SIGTERM);
+
+    if (waitpid(pid, &status, 0) == -1)
+        die("waitpid");
+
+    if (benchmark)
+        return 0;
+
+    return WIFEXITED(status) ? WEXITSTATUS(status) : 1;
+}
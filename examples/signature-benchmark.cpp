@@ -0,0 +1,99 @@
+/*
+ * Measures how many items are rejected by character signatures and how
+ * much faster filtering gets (same item storage, signatures and text
+ * matcher as sprinter uses for simple queries).
+ *
+ * Reads items from stdin (one per line) and prints results for each query.
+ *
+ * build (from this directory):
+ *   g++ -O2 -fPIC -I../src signature-benchmark.cpp ../src/item.cpp \
+ *       $(pkg-config --cflags --libs Qt5Core) -o signature-benchmark
+ *
+ * usage: find / | ./signature-benchmark QUERY...
+ */
+#include "item.h"
+
+#include <QElapsedTimer>
+#include <QStringMatcher>
+#include <QVector>
+
+#include <cstdio>
+#include <cstdlib>
+
+/* each query is searched this many times */
+static const int repeat = 10;
+
+static int filterAll(const QVector<Item> &items, const QStringMatcher &matcher)
+{
+    int count = 0;
+    for (int i = 0; i < items.size(); ++i) {
+        if ( matcher.indexIn(items[i].text()) != -1 )
+            ++count;
+    }
+    return count;
+}
+
+static int filterCandidates(const QVector<Item> &items, const QVector<quint64> &signatures,
+                            quint64 signature, const QStringMatcher &matcher, int *candidates)
+{
+    int count = 0;
+    *candidates = 0;
+    for (int i = 0; i < items.size(); ++i) {
+        if ( (signatures[i] & signature) != signature )
+            continue;
+        ++*candidates;
+        if ( matcher.indexIn(items[i].text()) != -1 )
+            ++count;
+    }
+    return count;
+}
+
+int main(int argc, char *argv[])
+{
+    QVector<Item> items;
+    QVector<quint64> signatures;
+
+    char *line = NULL;
+    size_t capacity = 0;
+    ssize_t size;
+    while ( (size = getline(&line, &capacity, stdin)) != -1 ) {
+        if (size > 0 && line[size - 1] == '\n')
+            --size;
+        items.append( Item(line, size) );
+        signatures.append( textSignature(line, size) );
+    }
+    free(line);
+
+    fprintf(stderr, "%d items\n", items.size());
+    printf("%-12s %9s %9s %8s\n", "query", "matches", "rejected", "speedup");
+
+    for (int i = 1; i < argc; ++i) {
+        const QString query = QString::fromLocal8Bit(argv[i]);
+        const QStringMatcher matcher(query, Qt::CaseInsensitive);
+        const quint64 signature = textSignature(query);
+
+        QElapsedTimer timer;
+        timer.start();
+        int matches = 0;
+        for (int j = 0; j < repeat; ++j)
+            matches = filterAll(items, matcher);
+        const qint64 all = timer.nsecsElapsed();
+
+        timer.start();
+        int candidates = 0;
+        int matches2 = 0;
+        for (int j = 0; j < repeat; ++j)
+            matches2 = filterCandidates(items, signatures, signature, matcher, &candidates);
+        const qint64 filtered = timer.nsecsElapsed();
+
+        if (matches != matches2)
+            fprintf(stderr, "%s: signatures rejected matching items!\n", argv[i]);
+
+        const double rejected = items.isEmpty()
+                ? 0 : 100.0 * (items.size() - candidates) / items.size();
+        printf("%-12s %9d %8.0f%% %7.1fx\n", argv[i], matches, rejected,
+               filtered > 0 ? double(all) / filtered : 0.0);
+    }
+
+    return 0;
+}
@@ -9,14 +9,42 @@ QT += core gui widgets
 TARGET = sprinter
 TEMPLATE = app
 
+INCLUDEPATH += src
+
 SOURCES += \
     src/main.cpp \
+    src/completionindex.cpp \
     src/dialog.cpp \
-    src/itemmodel.cpp
+    src/filewalker.cpp \
+    src/item.cpp \
+    src/itemdelegate.cpp \
+    src/itemfilter.cpp \
+    src/itemmodel.cpp \
+    src/linequeue.cpp \
+    src/listview.cpp \
+    src/pathindex.cpp \
+    src/replay.cpp \
+    src/sharedinput.cpp \
+    src/sourcereader.cpp \
+    src/trace.cpp \
+    src/watchdog.cpp
 
 HEADERS += \
+    src/completionindex.h \
     src/dialog.h \
-    src/itemmodel.h
+    src/filewalker.h \
+    src/item.h \
+    src/itemdelegate.h \
+    src/itemfilter.h \
+    src/itemmodel.h \
+    src/linequeue.h \
+    src/listview.h \
+    src/pathindex.h \
+    src/replay.h \
+    src/sharedinput.h \
+    src/sourcereader.h \
+    src/trace.h \
+    src/watchdog.h
 
 FORMS += ui/dialog.ui
 
@@ -0,0 +1,155 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "completionindex.h"
+
+#include "itemmodel.h"
+#include "trace.h"
+
+/* rebuild index if offset gets too far from zero */
+static const int max_row_offset = 1 << 30;
+
+/* drop removed rows from bucket if they take more space than this */
+static const int min_compact_rows = 1024;
+
+CompletionIndex::CompletionIndex(ItemModel *model, QObject *parent)
+    : QObject(parent)
+    , m_model(model)
+    , m_indexed(0)
+    , m_base(0)
+    , m_valid(true)
+    , m_position(0)
+{
+    connect( model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+             this, SLOT(rowsInserted(QModelIndex,int,int)) );
+    connect( model, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+             this, SLOT(rowsRemoved(QModelIndex,int,int)) );
+    connect( model, SIGNAL(modelReset()),
+             this, SLOT(invalidate()) );
+}
+
+QString CompletionIndex::complete(const QString &text)
+{
+    if ( text.isEmpty() )
+        return QString();
+
+    TRACE_SPAN("CompletionIndex::complete");
+
+    update();
+
+    const Bucket &b = m_buckets[ bucket(text[0]) ];
+
+    /* longer text can only match at or after last match */
+    int i = b.start;
+    if ( !m_text.isEmpty() && text.startsWith(m_text, Qt::CaseInsensitive) )
+        i = qMax(i, m_position);
+
+    QString completion;
+    for ( ; i < b.rows.size(); ++i ) {
+        completion = m_model->itemText(b.rows[i] - m_base);
+        if ( completion.startsWith(text, Qt::CaseInsensitive) )
+            break;
+    }
+
+    m_text = text;
+    m_position = i;
+
+    return i < b.rows.size() ? completion : QString();
+}
+
+void CompletionIndex::rowsInserted(const QModelIndex &, int first, int last)
+{
+    if (!m_valid)
+        return;
+
+    if (first == m_indexed)
+        addRows(first, last);
+    else if (first < m_indexed)
+        invalidate();
+}
+
+void CompletionIndex::rowsRemoved(const QModelIndex &, int first, int last)
+{
+    if (!m_valid || first >= m_indexed)
+        return;
+
+    /* only oldest items can be removed without rebuilding index */
+    if (first != 0) {
+        invalidate();
+        return;
+    }
+
+    for (int i = 0; i < BucketCount; ++i) {
+        Bucket &b = m_buckets[i];
+        while ( b.start < b.rows.size() && b.rows[b.start] - m_base <= last )
+            ++b.start;
+
+        if ( b.start >= min_compact_rows && b.start > b.rows.size() / 2 ) {
+            b.rows.remove(0, b.start);
+            b.start = 0;
+            m_text.clear();
+        }
+    }
+
+    const int count = last - first + 1;
+    m_base += count;
+    m_indexed = qMax(0, m_indexed - count);
+
+    if (m_base > max_row_offset)
+        invalidate();
+}
+
+void CompletionIndex::invalidate()
+{
+    m_valid = false;
+}
+
+int CompletionIndex::bucket(QChar c)
+{
+    const ushort u = c.toCaseFolded().unicode();
+    return u < BucketCount - 1 ? u : BucketCount - 1;
+}
+
+void CompletionIndex::update()
+{
+    if (!m_valid) {
+        for (int i = 0; i < BucketCount; ++i)
+            m_buckets[i] = Bucket();
+        m_indexed = 0;
+        m_base = 0;
+        m_text.clear();
+        m_valid = true;
+    }
+
+    const int count = m_model->rowCount();
+    if (m_indexed < count)
+        addRows(m_indexed, count - 1);
+}
+
+void CompletionIndex::addRows(int first, int last)
+{
+    TRACE_SPAN("CompletionIndex::addRows");
+
+    for (int row = first; row <= last; ++row) {
+        const QChar c = m_model->firstChar(row);
+        if ( !c.isNull() )
+            m_buckets[ bucket(c) ].rows.append(row + m_base);
+    }
+    m_indexed = last + 1;
+}
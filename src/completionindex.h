@@ -0,0 +1,80 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef COMPLETIONINDEX_H
+#define COMPLETIONINDEX_H
+
+#include <QObject>
+#include <QString>
+#include <QVector>
+
+class ItemModel;
+class QModelIndex;
+
+/*
+ * Finds first item starting with given text (case-insensitive) for inline
+ * completion.
+ *
+ * Rows are grouped by first character so only items with the same first
+ * character are compared. Appended rows are indexed when inserted (only
+ * first character is decoded) and searching for longer text continues
+ * from last match.
+ */
+class CompletionIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit CompletionIndex(ItemModel *model, QObject *parent = NULL);
+
+    /* returns empty string if no item starts with text */
+    QString complete(const QString &text);
+
+private slots:
+    void rowsInserted(const QModelIndex &parent, int first, int last);
+    void rowsRemoved(const QModelIndex &parent, int first, int last);
+    void invalidate();
+
+private:
+    enum { BucketCount = 129 };
+
+    struct Bucket {
+        Bucket() : start(0) {}
+        /* rows offset by m_base */
+        QVector<int> rows;
+        /* rows before start were removed */
+        int start;
+    };
+
+    static int bucket(QChar c);
+    void update();
+    void addRows(int first, int last);
+
+    ItemModel *m_model;
+    Bucket m_buckets[BucketCount];
+    /* number of indexed rows */
+    int m_indexed;
+    int m_base;
+    bool m_valid;
+
+    /* last completion */
+    QString m_text;
+    int m_position;
+};
+
+#endif // COMPLETIONINDEX_H
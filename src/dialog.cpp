@@ -20,11 +20,21 @@
 #include "dialog.h"
 #include "ui_dialog.h"
 
+#include "completionindex.h"
+#include "filewalker.h"
+#include "itemdelegate.h"
+#include "itemfilter.h"
 #include "itemmodel.h"
-
-#include <QCompleter>
+#include "pathindex.h"
+#include "sharedinput.h"
+#include "sourcereader.h"
+#include "trace.h"
+
+#include <QBitArray>
+#include <QDir>
+#include <QFileInfo>
+#include <QItemSelectionModel>
 #include <QKeyEvent>
-#include <QSortFilterProxyModel>
 #include <QTimer>
 
 #include <cstdio>
@@ -35,10 +45,16 @@ Dialog::Dialog(QWidget *parent) :
                 /*Qt::X11BypassWindowManagerHint |*/
                 /*Qt::FramelessWindowHint*/),
     ui(new Ui::Dialog),
+    m_walker(NULL),
+    m_sources(NULL),
     m_exit_code(1),
     m_strict(false),
     m_output(NULL),
-    m_hide_list(false)
+    m_hide_list(false),
+    m_multi_selection(false),
+    m_walk_depth(1),
+    m_show_hidden(false),
+    m_tag_sources(false)
 {
     ui->setupUi(this);
 
@@ -53,12 +69,17 @@ Dialog::Dialog(QWidget *parent) :
     m_model = new ItemModel(view);
 
     /* filtering */
-    m_proxy = new QSortFilterProxyModel(this);
-    m_proxy->setDynamicSortFilter(true);
+    m_proxy = new ItemFilter(this);
     m_proxy->setSourceModel(m_model);
+    m_proxy->setFilterRole(ItemModel::FilterRole);
     m_proxy->setFilterCaseSensitivity(Qt::CaseInsensitive);
     m_proxy->setSortCaseSensitivity(Qt::CaseInsensitive);
     view->setModel(m_proxy);
+    connect( m_proxy, SIGNAL(filterFinished()),
+             this, SIGNAL(filterUpdated()) );
+
+    /* highlight matched text */
+    view->setItemDelegate( new ItemDelegate(m_proxy, view) );
 
     /* signals & slots */
     connect( view, SIGNAL(activated(QModelIndex)),
@@ -76,10 +97,7 @@ Dialog::Dialog(QWidget *parent) :
     setLabel("");
 
     /* completion */
-    QCompleter *completer = new QCompleter(m_model, this);
-    completer->setCompletionMode(QCompleter::InlineCompletion);
-    completer->setCaseSensitivity(Qt::CaseInsensitive);
-    edit->setCompleter(completer);
+    m_completion = new CompletionIndex(m_model, this);
 
     /* focus edit line */
     edit->setFocus();
@@ -92,24 +110,13 @@ Dialog::~Dialog()
 
 void Dialog::closeEvent(QCloseEvent *)
 {
-    if (!m_exit_code && m_output) {
-        int a = 0, b = 0;
-        QString text = ui->lineEdit->text();
-
-        while ( (b = text.indexOf('\n', a)) > 0 ) {
-            m_output->append( text.mid(a, b-a).toLocal8Bit() );
-            a = b+1;
-        }
-        if ( a != text.size() )
-            m_output->append( text.mid(a).toLocal8Bit() );
-    }
     qApp->exit(m_exit_code);
 }
 
 void Dialog::textEdited(const QString &text)
 {
-    if (!m_hide_list)
-        updateFilter(300);
+    m_multi_selection = false;
+    updateFilter(300);
     m_original_text = text;
 }
 
@@ -138,6 +145,176 @@ void Dialog::setGridSize(int w, int h)
     m_model->setItemSize(size);
 }
 
+void Dialog::setTailSize(int size)
+{
+    m_model->setTailSize(size);
+}
+
+void Dialog::setFrameMode(bool enable)
+{
+    m_model->setFrameMode(enable);
+}
+
+void Dialog::setDelimiter(char delimiter)
+{
+    m_model->setDelimiter(delimiter);
+    if (m_sources)
+        m_sources->setDelimiter(delimiter);
+}
+
+void Dialog::setFilterField(int field)
+{
+    m_model->setField(ItemModel::FilterField, field);
+}
+
+void Dialog::setDisplayField(int field)
+{
+    m_model->setField(ItemModel::DisplayField, field);
+}
+
+void Dialog::setOutputField(int field)
+{
+    m_model->setField(ItemModel::OutputField, field);
+}
+
+void Dialog::setRegexMode(bool enable)
+{
+    m_proxy->setRegexMode(enable);
+}
+
+void Dialog::walk(const QString &dir)
+{
+    if (!m_walker) {
+        m_walker = new FileWalker(this);
+        m_walker->setMaxDepth(m_walk_depth);
+        m_walker->setShowHidden(m_show_hidden);
+        m_model->closeStdin();
+        connect( m_walker, SIGNAL(rootChanged(QString)),
+                 m_model, SLOT(setBaseDirectory(QString)) );
+        connect( m_walker, SIGNAL(itemsFound(QByteArray)),
+                 m_model, SLOT(addItems(QByteArray)) );
+    }
+
+    /* start after all options are set */
+    QMetaObject::invokeMethod( m_walker, "start", Qt::QueuedConnection,
+                               Q_ARG(QString, dir) );
+}
+
+void Dialog::setWalkDepth(int depth)
+{
+    m_walk_depth = depth;
+    if (m_walker)
+        m_walker->setMaxDepth(depth);
+}
+
+void Dialog::setShowHidden(bool show)
+{
+    m_show_hidden = show;
+    if (m_walker)
+        m_walker->setShowHidden(show);
+}
+
+void Dialog::listPathExecutables()
+{
+    PathIndex *index = new PathIndex(this);
+    m_model->closeStdin();
+    connect( index, SIGNAL(itemsChanged(QByteArray)),
+             m_model, SLOT(setItems(QByteArray)) );
+    QMetaObject::invokeMethod(index, "start", Qt::QueuedConnection);
+}
+
+bool Dialog::readSharedMemory(int memoryFd, int eventFd)
+{
+    SharedInput *input = new SharedInput(this);
+    if ( !input->open(memoryFd, eventFd) ) {
+        delete input;
+        return false;
+    }
+
+    m_model->closeStdin();
+    connect( input, SIGNAL(itemsRead(QVector<Item>)),
+             m_model, SLOT(addItems(QVector<Item>)) );
+    return true;
+}
+
+void Dialog::readSource(const QString &command)
+{
+    sourceReader()->addCommand(command);
+}
+
+void Dialog::readInput(const QString &fileName)
+{
+    sourceReader()->addFile(fileName);
+}
+
+void Dialog::setTagSources(bool enable)
+{
+    m_tag_sources = enable;
+    if (m_sources)
+        m_sources->setTagItems(enable);
+}
+
+void Dialog::stopSources()
+{
+    if (m_sources)
+        m_sources->stop();
+}
+
+SourceReader *Dialog::sourceReader()
+{
+    if (!m_sources) {
+        m_sources = new SourceReader(this);
+        m_sources->setTagItems(m_tag_sources);
+        m_sources->setDelimiter(m_model->delimiter());
+        m_model->closeStdin();
+        connect( m_sources, SIGNAL(itemsRead(QByteArray)),
+                 m_model, SLOT(addItems(QByteArray)) );
+
+        /* start after all options are set */
+        QMetaObject::invokeMethod(m_sources, "start", Qt::QueuedConnection);
+    }
+
+    return m_sources;
+}
+
+bool Dialog::enterDirectory(const QString &path)
+{
+    QString dir;
+    if ( path == "~" || path.startsWith("~/") ) {
+        /* "~" is home directory */
+        dir = QDir::homePath() + path.mid(1);
+    } else {
+        if ( !path.endsWith('/') )
+            return false;
+        dir = QDir( QFile::decodeName(m_walker->root()) ).filePath(path);
+    }
+
+    if ( !QFileInfo(dir).isDir() )
+        return false;
+
+    /* list new directory in same window */
+    m_multi_selection = false;
+    m_original_text.clear();
+    ui->lineEdit->clear();
+    m_proxy->setPattern( QString() );
+    m_model->clear();
+    connect( m_model, SIGNAL(rowsInserted(QModelIndex,int,int)),
+             this, SLOT(firstRowInserted()),
+             Qt::ConnectionType(Qt::DirectConnection | Qt::UniqueConnection) );
+    m_walker->start(dir);
+
+    ui->lineEdit->setFocus();
+    return true;
+}
+
+QByteArray Dialog::outputBytes(const QByteArray &bytes) const
+{
+    /* print full path of files */
+    if ( !m_walker || bytes.startsWith('/') )
+        return bytes;
+    return m_walker->root() + bytes;
+}
+
 void Dialog::sortList()
 {
     m_proxy->sort(0);
@@ -145,14 +322,15 @@ void Dialog::sortList()
 
 void Dialog::setFilter(const QString &currentText)
 {
+    TRACE_SPAN("Dialog::setFilter");
+
     QString filter = currentText;
 
-    /* filter items */
-    /*
-    filter.replace(' ', ".*");
-    m_proxy->setFilterRegExp( QRegExp(filter, Qt::CaseInsensitive) );
-    */
-    m_proxy->setFilterWildcard(filter);
+    /* filter items (keep last valid filter while user types) */
+    const bool valid = m_proxy->setPattern(filter);
+    ui->lineEdit->setToolTip( m_proxy->errorString() );
+    if (!valid)
+        return;
 
     /* select first item that starts with matched text */
     QModelIndexList list = m_proxy->match( m_proxy->index(0,0), Qt::DisplayRole,
@@ -170,12 +348,45 @@ void Dialog::firstRowInserted()
             ui->listView->setCurrentIndex(index);
             ui->lineEdit->setText( index.data().toString() );
             ui->lineEdit->selectAll();
+        } else if ( !m_proxy->sourceModel() && m_model->rowCount() > 0 ) {
+            ui->lineEdit->setText( m_model->itemText(0) );
+            ui->lineEdit->selectAll();
         }
     }
     disconnect( m_model, SIGNAL(rowsInserted(QModelIndex,int,int)),
                 this, SLOT(firstRowInserted()) );
 }
 
+void Dialog::populateList()
+{
+    if ( !m_proxy->sourceModel() )
+        m_proxy->setSourceModel(m_model);
+}
+
+void Dialog::complete()
+{
+    QLineEdit *const edit = ui->lineEdit;
+    const QString text = edit->text();
+    if ( edit->hasSelectedText() || edit->cursorPosition() != text.size() )
+        return;
+
+    const QString completion = m_completion->complete(text);
+    if ( completion.size() > text.size() ) {
+        edit->setText(completion);
+        edit->setSelection( text.size(), completion.size() - text.size() );
+    }
+}
+
+int Dialog::sourceRow(const QString &text) const
+{
+    /* try current item first */
+    const QModelIndex index = m_proxy->mapToSource( ui->listView->currentIndex() );
+    if ( index.isValid() && m_model->itemText(index.row()) == text )
+        return index.row();
+
+    return m_model->indexOf(text);
+}
+
 QString Dialog::unselectedText() const
 {
     QLineEdit *const edit = ui->lineEdit;
@@ -193,7 +404,20 @@ void Dialog::updateFilter(int interval)
         if ( !ui->lineEdit->hasFocus() )
             return;
         QString filter = unselectedText();
-        setFilter(filter);
+        emit filterStarted();
+
+        /* only prepare hidden list in background */
+        if ( m_hide_list && !ui->listView->isVisible() ) {
+            m_proxy->setPattern(filter);
+            ui->lineEdit->setToolTip( m_proxy->errorString() );
+            populateList();
+        } else {
+            setFilter(filter);
+        }
+
+        /* otherwise emitted after incremental filtering finishes */
+        if ( !m_proxy->isFiltering() )
+            emit filterUpdated();
         return;
     }
 
@@ -217,6 +441,13 @@ void Dialog::hideList(bool hide)
     m_hide_list = hide;
     ui->listView->setHidden(hide);
 
+    /* list is populated only when user starts typing or shows it */
+    if (!hide)
+        populateList();
+    else if ( !isVisible() )
+        m_proxy->setSourceModel(NULL);
+    m_proxy->setIncremental(hide);
+
     /* resize automatically */
     resize(0,0);
     adjustSize();
@@ -240,8 +471,11 @@ void Dialog::popList()
         resize( width(), m_height );
     }
 
-    if (m_hide_list)
-        updateFilter();
+    if (m_hide_list) {
+        populateList();
+        m_proxy->setIncremental(false);
+        setFilter( unselectedText() );
+    }
 
     /* show and focus list */
     index = view->selectionModel()->hasSelection() ?
@@ -271,17 +505,25 @@ void Dialog::itemSelected(const QItemSelection &,
     if ( edit->hasFocus() )
         return;
 
-    QModelIndexList indexes =
-            ui->listView->selectionModel()->selectedIndexes();
-
-    QStringList captions;
-    foreach (QModelIndex index, indexes) {
-        QVariant data = index.data();
-        if ( data.isValid() )
-            captions.append( data.toString() );
+    /* count selected rows - selection is kept as ranges, items are not copied */
+    const QItemSelection selection =
+            ui->listView->selectionModel()->selection();
+    int count = 0;
+    foreach (const QItemSelectionRange &range, selection)
+        count += range.height();
+
+    /* show only summary for multiple items */
+    if (count > 1) {
+        m_multi_selection = true;
+        edit->setText( tr("%n items selected", "", count) );
+        return;
     }
+    m_multi_selection = false;
+
+    QString text2;
+    if (count == 1)
+        text2 = selection.first().topLeft().data().toString();
 
-    QString text2 = captions.join("\n");
     edit->setText(text2);
     if ( text2.startsWith(m_original_text, Qt::CaseInsensitive) )
         edit->setSelection( m_original_text.length(), text2.length() );
@@ -289,27 +531,86 @@ void Dialog::itemSelected(const QItemSelection &,
 
 void Dialog::submit()
 {
-    QLineEdit *const edit = ui->lineEdit;
-    QString text;
-
-    if ( edit->selectionStart() >= 0 )
-        text = edit->completer()->currentCompletion();
+    if (m_multi_selection) {
+        submitSelection();
+        return;
+    }
 
-    if ( text.isEmpty() || text.compare(edit->text(), Qt::CaseInsensitive) )
-        text = edit->text();
+    /* inline completion is already part of the text */
+    const QString text = ui->lineEdit->text();
 
-    if (m_strict && m_model->items().indexOf(text) == -1 )
+    if ( m_walker && enterDirectory(text) )
         return;
 
-    /* print to stdout */
-    if ( !m_output ) {
-        printf( "%s", text.toLocal8Bit().constData() );
+    /* item is needed to print output field */
+    int row = -1;
+    if ( m_strict || m_model->hasFields() ) {
+        row = sourceRow(text);
+        if (m_strict && row == -1)
+            return;
+    }
+
+    const QByteArray bytes = outputBytes(
+                row != -1 ? m_model->itemBytes(row) : text.toLocal8Bit() );
+    if (m_output) {
+        m_output->append(bytes);
+    } else {
+        /* print to stdout */
+        fwrite( bytes.constData(), 1, bytes.size(), stdout );
+    }
+
+    m_exit_code = 0;
+    close();
+}
+
+void Dialog::submitSelection()
+{
+    const QItemSelection selection =
+            ui->listView->selectionModel()->selection();
+
+    /* map selected ranges to source rows (keeps original item order) */
+    QBitArray rows( m_model->rowCount() );
+    foreach (const QItemSelectionRange &range, selection) {
+        for (int row = range.top(); row <= range.bottom(); ++row) {
+            const QModelIndex index =
+                    m_proxy->mapToSource( m_proxy->index(row, 0) );
+            if ( index.isValid() )
+                rows.setBit( index.row() );
+        }
     }
 
+    writeItems(rows);
+
     m_exit_code = 0;
     close();
 }
 
+void Dialog::writeItems(const QBitArray &rows)
+{
+    static char buffer[1 << 16];
+    const int len = rows.size();
+    bool first = true;
+
+    if (!m_output)
+        setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+
+    for (int row = 0; row < len; ++row) {
+        if ( !rows.testBit(row) )
+            continue;
+
+        const QByteArray bytes = outputBytes( m_model->itemBytes(row) );
+        if (m_output) {
+            m_output->append(bytes);
+        } else {
+            /* items are separated by new line (no new line at the end) */
+            if (!first)
+                fputc('\n', stdout);
+            fwrite( bytes.constData(), 1, bytes.size(), stdout );
+        }
+        first = false;
+    }
+}
+
 void Dialog::submitCurrentItem(const QModelIndex &index)
 {
     if ( index.isValid() ) {
@@ -358,9 +659,8 @@ bool Dialog::eventFilter(QObject *obj, QEvent *event)
         case Qt::Key_Tab:
             if (obj == edit) {
                 if ( edit->selectionStart() >= 0 ) {
-                    text = edit->completer()->currentCompletion();
-                    if ( !text.isEmpty() )
-                        edit->setText(text);
+                    /* accept completion */
+                    edit->end(false);
                 } else {
                     popList();
                 }
@@ -393,10 +693,24 @@ bool Dialog::eventFilter(QObject *obj, QEvent *event)
                 if ( !text.isEmpty() ) {
                     edit->setFocus();
                     edit->event(event);
+                    if ( text.at(0).isPrint() )
+                        complete();
                     if (!m_hide_list)
                         updateFilter(300);
                     return true;
                 }
+            } else if (obj == edit) {
+                text = e->text();
+                const bool typed = !text.isEmpty() && text.at(0).isPrint();
+                if (!typed && !trace_flags)
+                    break;
+
+                /* measure editing including inline completion */
+                TRACE_SPAN("QLineEdit::keyPressEvent");
+                edit->event(event);
+                if (typed)
+                    complete();
+                return true;
             }
             break;
         }
@@ -415,8 +729,9 @@ void Dialog::keyPressEvent(QKeyEvent *event)
             /* if selection is at top of list (or wrapped column in list)
              * and user wants to move up then select lineedit
              */
-            if ( m_original_text != unselectedText() )
+            if ( m_multi_selection || m_original_text != unselectedText() )
                 edit->setText(m_original_text);
+            m_multi_selection = false;
             edit->setFocus();
             event->accept();
         } else if (key == Qt::Key_Down || key == Qt::Key_PageDown) {
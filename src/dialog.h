@@ -22,10 +22,14 @@
 
 #include <QDialog>
 
+class CompletionIndex;
+class FileWalker;
+class ItemFilter;
 class ItemModel;
+class QBitArray;
 class QItemSelection;
 class QModelIndex;
-class QSortFilterProxyModel;
+class SourceReader;
 
 namespace Ui {
     class Dialog;
@@ -44,6 +48,23 @@ public:
     void setGridSize(int w, int h);
     void setStrict(bool enable) {m_strict = enable;}
     void saveOutput(QList<QByteArray> *output) {m_output = output;}
+    void setTailSize(int size);
+    void setFrameMode(bool enable);
+    void setDelimiter(char delimiter);
+    void setFilterField(int field);
+    void setDisplayField(int field);
+    void setOutputField(int field);
+    void setRegexMode(bool enable);
+    void walk(const QString &dir);
+    void setWalkDepth(int depth);
+    void setShowHidden(bool show);
+    void listPathExecutables();
+    bool readSharedMemory(int memoryFd, int eventFd);
+    void readSource(const QString &command);
+    void readInput(const QString &fileName);
+    void setTagSources(bool enable);
+    /* terminate commands started with readSource() */
+    void stopSources();
     void sortList();
     void hideList(bool hide);
     void popList();
@@ -53,20 +74,42 @@ public:
 private:
     Ui::Dialog *ui;
     ItemModel *m_model;
-    QSortFilterProxyModel *m_proxy;
+    ItemFilter *m_proxy;
+    CompletionIndex *m_completion;
+    FileWalker *m_walker;
+    SourceReader *m_sources;
     QString m_original_text;
     int m_exit_code;
     bool m_strict;
     QList<QByteArray> *m_output;
     bool m_hide_list;
     int m_height;
+    bool m_multi_selection;
+    int m_walk_depth;
+    bool m_show_hidden;
+    bool m_tag_sources;
 
     QString unselectedText() const;
+    void populateList();
+    void complete();
+    int sourceRow(const QString &text) const;
+    SourceReader *sourceReader();
+    bool enterDirectory(const QString &path);
+    QByteArray outputBytes(const QByteArray &bytes) const;
+    void submitSelection();
+    void writeItems(const QBitArray &rows);
 
 protected:
     void closeEvent(QCloseEvent *);
     void keyPressEvent(QKeyEvent *event);
 
+signals:
+    /* filtering list with current text started */
+    void filterStarted();
+
+    /* list was filtered with text given when filterStarted() was emitted */
+    void filterUpdated();
+
 public slots:
     void setFilter(const QString &currentText);
     void itemSelected(const QItemSelection &selected,
@@ -0,0 +1,164 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "filewalker.h"
+
+#include "trace.h"
+
+#include <QDir>
+#include <QFile>
+#include <QRunnable>
+
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+/* emit found items after collecting this many bytes in single directory */
+static const int walk_batch_size = 64 * 1024;
+
+class WalkTask : public QRunnable
+{
+public:
+    WalkTask(FileWalker *walker, const QByteArray &root, const QByteArray &path,
+             int depth, int generation)
+        : m_walker(walker)
+        , m_root(root)
+        , m_path(path)
+        , m_depth(depth)
+        , m_generation(generation)
+    {
+    }
+
+    void run()
+    {
+        m_walker->walk(m_root, m_path, m_depth, m_generation);
+    }
+
+private:
+    FileWalker *m_walker;
+    QByteArray m_root;
+    QByteArray m_path;
+    int m_depth;
+    int m_generation;
+};
+
+FileWalker::FileWalker(QObject *parent)
+    : QObject(parent)
+    , m_maxDepth(1)
+    , m_showHidden(false)
+{
+    connect( &m_found, SIGNAL(linesAdded(QByteArray)),
+             this, SIGNAL(itemsFound(QByteArray)) );
+}
+
+FileWalker::~FileWalker()
+{
+    /* cancel */
+    m_generation.fetchAndAddOrdered(1);
+    m_pool.waitForDone();
+}
+
+void FileWalker::start(const QString &root)
+{
+    const QString path = QDir(root).canonicalPath();
+    if ( path.isEmpty() )
+        return;
+
+    m_root = QFile::encodeName(path);
+    if ( !m_root.endsWith('/') )
+        m_root.append('/');
+
+    /* cancel current walk */
+    const int generation = m_generation.fetchAndAddOrdered(1) + 1;
+    m_found.reset(generation);
+
+    emit rootChanged(path);
+
+    if (m_root != "/")
+        m_found.append("../\n", generation);
+
+    spawn(m_root, QByteArray(), 1, generation);
+}
+
+void FileWalker::spawn(const QByteArray &root, const QByteArray &path, int depth, int generation)
+{
+    m_pool.start( new WalkTask(this, root, path, depth, generation) );
+}
+
+void FileWalker::walk(const QByteArray &root, const QByteArray &path, int depth, int generation)
+{
+    TRACE_SPAN("FileWalker::walk");
+
+    DIR *dir = NULL;
+    if ( generation == m_generation.loadAcquire() )
+        dir = opendir( (root + path).constData() );
+
+    if (dir) {
+        const bool recursive = m_maxDepth <= 0 || depth < m_maxDepth;
+        QByteArray lines;
+        /* files are listed after directories */
+        QByteArray files;
+        struct dirent *entry;
+
+        /* readdir() reads entries in batches (getdents) */
+        while ( (entry = readdir(dir)) != NULL ) {
+            const char *name = entry->d_name;
+
+            /* skip "." and ".." and hidden files */
+            if ( name[0] == '.' && (!m_showHidden || name[1] == '\0'
+                                    || (name[1] == '.' && name[2] == '\0')) )
+            {
+                continue;
+            }
+
+            /* item cannot contain new line */
+            if ( strchr(name, '\n') )
+                continue;
+
+            bool isDir = entry->d_type == DT_DIR;
+            bool follow = isDir;
+            if (entry->d_type == DT_UNKNOWN || entry->d_type == DT_LNK) {
+                struct stat info;
+                if ( fstatat(dirfd(dir), name, &info, 0) == 0 )
+                    isDir = S_ISDIR(info.st_mode);
+                /* don't follow symbolic links to directories */
+                if (entry->d_type == DT_UNKNOWN && isDir)
+                    follow = fstatat(dirfd(dir), name, &info, AT_SYMLINK_NOFOLLOW) == 0
+                            && S_ISDIR(info.st_mode);
+            }
+
+            if (isDir)
+                lines.append(path).append(name).append("/\n");
+            else
+                files.append(path).append(name).append('\n');
+
+            if (follow && recursive)
+                spawn( root, path + name + '/', depth + 1, generation );
+
+            if ( lines.size() >= walk_batch_size ) {
+                m_found.append(lines, generation);
+                lines.clear();
+            }
+        }
+        closedir(dir);
+
+        m_found.append(lines + files, generation);
+    }
+}
@@ -0,0 +1,79 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef FILEWALKER_H
+#define FILEWALKER_H
+
+#include "linequeue.h"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QObject>
+#include <QThreadPool>
+
+/*
+ * Lists files in directory tree using thread pool (one task per directory).
+ *
+ * Paths relative to root directory are emitted in batches as lines
+ * (directories end with slash; directories are listed before files of the
+ * same directory). Starting again with different root cancels current walk.
+ */
+class FileWalker : public QObject
+{
+    Q_OBJECT
+public:
+    explicit FileWalker(QObject *parent = NULL);
+    ~FileWalker();
+
+    /* maximum directory depth (0 for unlimited) */
+    void setMaxDepth(int depth) { m_maxDepth = depth; }
+
+    void setShowHidden(bool show) { m_showHidden = show; }
+
+    /* encoded path to root directory (ends with slash) */
+    QByteArray root() const { return m_root; }
+
+    /* called from pool threads */
+    void walk(const QByteArray &root, const QByteArray &path, int depth, int generation);
+
+public slots:
+    void start(const QString &root);
+
+signals:
+    /* walk started in new root directory */
+    void rootChanged(const QString &root);
+
+    /* new line separated paths */
+    void itemsFound(const QByteArray &lines);
+
+private:
+    void spawn(const QByteArray &root, const QByteArray &path, int depth, int generation);
+
+    QThreadPool m_pool;
+    QByteArray m_root;
+    int m_maxDepth;
+    bool m_showHidden;
+
+    QAtomicInt m_generation;
+
+    /* items found but not yet emitted */
+    LineQueue m_found;
+};
+
+#endif // FILEWALKER_H
@@ -0,0 +1,195 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "item.h"
+
+#include <cstring>
+
+static const quint64 non_ascii_mask = Q_UINT64_C(0x8080808080808080);
+
+static const quint64 non_ascii_bit = Q_UINT64_C(1) << 63;
+
+/* letters and digits have own bits, other characters share remaining bits */
+static quint64 asciiSignature(uint c)
+{
+    if (c >= 'A' && c <= 'Z')
+        c += 'a' - 'A';
+
+    if (c >= 'a' && c <= 'z')
+        return Q_UINT64_C(1) << (c - 'a');
+    if (c >= '0' && c <= '9')
+        return Q_UINT64_C(1) << (26 + c - '0');
+    return Q_UINT64_C(1) << (36 + c % 27);
+}
+
+namespace {
+
+struct SignatureTable {
+    SignatureTable()
+    {
+        /*
+         * Some non-ASCII characters match ASCII letters if case is ignored
+         * (dotted and dotless I, long S and Kelvin sign).
+         */
+        const quint64 non_ascii = non_ascii_bit
+                | asciiSignature('i') | asciiSignature('k') | asciiSignature('s');
+        for (uint c = 0; c < 256; ++c)
+            bits[c] = c < 0x80 ? asciiSignature(c) : non_ascii;
+    }
+
+    quint64 bits[256];
+};
+
+} // namespace
+
+int asciiLength(const char *data, int size)
+{
+    int i = 0;
+
+    /* test eight bytes at once */
+    for ( ; i + 8 <= size; i += 8 ) {
+        quint64 chunk;
+        memcpy(&chunk, data + i, sizeof(chunk));
+        if (chunk & non_ascii_mask)
+            break;
+    }
+
+    while ( i < size && static_cast<uchar>(data[i]) < 0x80 )
+        ++i;
+
+    return i;
+}
+
+bool isValidUtf8(const char *data, int size)
+{
+    int i = 0;
+    while (true) {
+        i += asciiLength(data + i, size - i);
+        if (i == size)
+            return true;
+
+        const uchar c = data[i];
+        int n;
+        uint min;
+        if ( (c & 0xE0) == 0xC0 ) {
+            n = 1;
+            min = 0x80;
+        } else if ( (c & 0xF0) == 0xE0 ) {
+            n = 2;
+            min = 0x800;
+        } else if ( (c & 0xF8) == 0xF0 ) {
+            n = 3;
+            min = 0x10000;
+        } else {
+            return false;
+        }
+
+        if (size - i <= n)
+            return false;
+
+        uint code = c & (0x3F >> n);
+        for (int j = 1; j <= n; ++j) {
+            const uchar cc = data[i + j];
+            if ( (cc & 0xC0) != 0x80 )
+                return false;
+            code = (code << 6) | (cc & 0x3F);
+        }
+
+        /* reject overlong forms, surrogates and too large code points */
+        if ( code < min || code > 0x10FFFF || (code >= 0xD800 && code <= 0xDFFF) )
+            return false;
+
+        i += n + 1;
+    }
+}
+
+static uchar detectEncoding(const char *data, int size)
+{
+    const int ascii = asciiLength(data, size);
+    if (ascii == size)
+        return Item::Ascii;
+    if ( isValidUtf8(data + ascii, size - ascii) )
+        return Item::Utf8;
+    return Item::Local8Bit;
+}
+
+Item::Item(const char *data, int size)
+    : m_bytes(data, size)
+    , m_encoding( detectEncoding(data, size) )
+{
+}
+
+Item Item::fromRawData(const char *data, int size)
+{
+    Item item;
+    item.m_bytes = QByteArray::fromRawData(data, size);
+    item.m_encoding = detectEncoding(data, size);
+    return item;
+}
+
+QString Item::text() const
+{
+    if (m_encoding == Ascii)
+        return QString::fromLatin1(m_bytes);
+    if (m_encoding == Utf8)
+        return QString::fromUtf8(m_bytes);
+    return QString::fromLocal8Bit(m_bytes);
+}
+
+QString Item::text(int start, int size) const
+{
+    const char *data = m_bytes.constData() + start;
+    if (m_encoding == Ascii)
+        return QString::fromLatin1(data, size);
+    if (m_encoding == Utf8)
+        return QString::fromUtf8(data, size);
+    return QString::fromLocal8Bit(data, size);
+}
+
+quint64 textSignature(const char *data, int size)
+{
+    static const SignatureTable table;
+
+    quint64 signature = 0;
+    for (int i = 0; i < size; ++i)
+        signature |= table.bits[ static_cast<uchar>(data[i]) ];
+    return signature;
+}
+
+quint64 textSignature(const QString &text)
+{
+    quint64 signature = 0;
+    for (int i = 0; i < text.size(); ++i) {
+        const QChar c = text[i];
+        if ( c.unicode() < 0x80 ) {
+            signature |= asciiSignature( c.unicode() );
+            continue;
+        }
+
+        /* non-ASCII character can match ASCII letter if case is ignored */
+        const QChar variants[] = { c.toCaseFolded(), c.toLower(), c.toUpper() };
+        quint64 bit = non_ascii_bit;
+        for (int j = 0; j < 3; ++j) {
+            if ( variants[j].unicode() < 0x80 )
+                bit = asciiSignature( variants[j].unicode() );
+        }
+        signature |= bit;
+    }
+    return signature;
+}
@@ -0,0 +1,77 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEM_H
+#define ITEM_H
+
+#include <QByteArray>
+#include <QString>
+
+/*
+ * Item text stored as bytes read from input.
+ * ASCII items (most common) are kept as Latin-1 (one byte per character)
+ * and other items as UTF-8; text is widened to UTF-16 only when needed.
+ */
+class Item
+{
+public:
+    enum Encoding {
+        Ascii,
+        Utf8,
+        /* not valid UTF-8 */
+        Local8Bit
+    };
+
+    Item() : m_encoding(Ascii) {}
+    Item(const char *data, int size);
+
+    /* item using given data without copying (data must not change or be freed) */
+    static Item fromRawData(const char *data, int size);
+
+    QString text() const;
+
+    /* text of part of item (range in bytes) */
+    QString text(int start, int size) const;
+
+    /* original bytes (used for output) */
+    const QByteArray &bytes() const { return m_bytes; }
+
+    Encoding encoding() const { return static_cast<Encoding>(m_encoding); }
+
+    bool operator==(const Item &other) const { return m_bytes == other.m_bytes; }
+
+private:
+    QByteArray m_bytes;
+    uchar m_encoding;
+};
+
+/* length of ASCII-only prefix */
+int asciiLength(const char *data, int size);
+
+bool isValidUtf8(const char *data, int size);
+
+/*
+ * Set of characters in text as 64-bit mask (letters are case-folded).
+ * Text can contain other text (ignoring case) only if its signature has
+ * all bits of the other signature.
+ */
+quint64 textSignature(const char *data, int size);
+quint64 textSignature(const QString &text);
+
+#endif // ITEM_H
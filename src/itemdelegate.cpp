@@ -0,0 +1,148 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemdelegate.h"
+
+#include "itemfilter.h"
+
+#include <QApplication>
+#include <QFontMetrics>
+#include <QPainter>
+
+/* opacity of match highlight (0 to 255) */
+static const int highlight_alpha = 80;
+
+/* maximum number of cached highlighted areas */
+static const int highlight_cache_size = 4096;
+
+static int textWidth(const QFontMetrics &metrics, const QString &text)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(5,11,0)
+    return metrics.horizontalAdvance(text);
+#else
+    return metrics.width(text);
+#endif
+}
+
+/*
+ * Position in elided text (common prefix and suffix with original text
+ * are kept; anything in between is replaced by ellipsis).
+ */
+static int elidedPosition(int position, int size, int elidedSize, int prefix, int suffix, bool end)
+{
+    if (position <= prefix)
+        return position;
+    if (position >= size - suffix)
+        return elidedSize - (size - position);
+    return end ? prefix + 1 : prefix;
+}
+
+ItemDelegate::ItemDelegate(ItemFilter *filter, QObject *parent)
+    : QStyledItemDelegate(parent)
+    , m_filter(filter)
+{
+}
+
+void ItemDelegate::paint(QPainter *painter, const QStyleOptionViewItem &option,
+                         const QModelIndex &index) const
+{
+    int start;
+    int length;
+    if ( !m_filter->matchSpan(index, &start, &length) ) {
+        QStyledItemDelegate::paint(painter, option, index);
+        return;
+    }
+
+    /* same as QStyledItemDelegate::paint() but style option is needed later */
+    QStyleOptionViewItem opt = option;
+    initStyleOption(&opt, index);
+    const QWidget *widget = opt.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    style->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
+
+    if ( start + length > opt.text.size() )
+        return;
+
+    Highlight &highlight = m_highlights[opt.text];
+    if ( highlight.size != opt.rect.size() || highlight.start != start || highlight.length != length ) {
+        highlight.size = opt.rect.size();
+        highlight.start = start;
+        highlight.length = length;
+        highlight.rect = highlightRect(opt, start, length).translated( -opt.rect.topLeft() );
+    }
+
+    if ( highlight.rect.isEmpty() )
+        return;
+
+    QColor color = opt.palette.color( (opt.state & QStyle::State_Selected)
+                                      ? QPalette::HighlightedText : QPalette::Highlight );
+    color.setAlpha(highlight_alpha);
+    painter->fillRect( highlight.rect.translated(opt.rect.topLeft()) & opt.rect, color );
+
+    /* keep only areas for recently painted items */
+    if ( m_highlights.size() > highlight_cache_size )
+        m_highlights.clear();
+}
+
+QRect ItemDelegate::highlightRect(const QStyleOptionViewItem &opt, int start, int length) const
+{
+    const QString &text = opt.text;
+
+    /* same text area as in QCommonStyle (including margins and eliding) */
+    const QWidget *widget = opt.widget;
+    QStyle *style = widget ? widget->style() : QApplication::style();
+    const int margin = style->pixelMetric(QStyle::PM_FocusFrameHMargin, 0, widget) + 1;
+    const QRect textRect = style->subElementRect(QStyle::SE_ItemViewItemText, &opt, widget)
+            .adjusted(margin, 0, -margin, 0);
+
+    const QFontMetrics metrics(opt.font);
+    const QString elided = metrics.elidedText(text, opt.textElideMode, textRect.width());
+
+    int from = start;
+    int to = start + length;
+    if (elided != text) {
+        const int size = qMin( text.size(), elided.size() );
+        int prefix = 0;
+        while ( prefix < size && text[prefix] == elided[prefix] )
+            ++prefix;
+        int suffix = 0;
+        while ( prefix + suffix < size
+                && text[text.size() - suffix - 1] == elided[elided.size() - suffix - 1] )
+        {
+            ++suffix;
+        }
+
+        from = elidedPosition(from, text.size(), elided.size(), prefix, suffix, false);
+        to = elidedPosition(to, text.size(), elided.size(), prefix, suffix, true);
+    }
+
+    const int x1 = textWidth( metrics, elided.left(from) );
+    const int x2 = textWidth( metrics, elided.left(to) );
+    if (x2 <= x1)
+        return QRect();
+
+    int x = textRect.left();
+    if (opt.displayAlignment & Qt::AlignRight)
+        x = textRect.right() + 1 - textWidth(metrics, elided);
+    else if (opt.displayAlignment & Qt::AlignHCenter)
+        x += (textRect.width() - textWidth(metrics, elided)) / 2;
+
+    return QRect( x + x1, textRect.top() + (textRect.height() - metrics.height()) / 2,
+                  x2 - x1, metrics.height() );
+}
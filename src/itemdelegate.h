@@ -0,0 +1,61 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMDELEGATE_H
+#define ITEMDELEGATE_H
+
+#include <QHash>
+#include <QRect>
+#include <QStyledItemDelegate>
+
+class ItemFilter;
+
+/*
+ * Paints items and highlights part of text matching current filter.
+ *
+ * Match positions are taken from the filter (found while filtering), so
+ * painting doesn't search item text. Highlighted area is computed once for
+ * each item text and item size.
+ */
+class ItemDelegate : public QStyledItemDelegate
+{
+    Q_OBJECT
+public:
+    explicit ItemDelegate(ItemFilter *filter, QObject *parent = NULL);
+
+    void paint(QPainter *painter, const QStyleOptionViewItem &option,
+               const QModelIndex &index) const;
+
+private:
+    struct Highlight {
+        QSize size;
+        int start;
+        int length;
+        /* relative to item rectangle */
+        QRect rect;
+    };
+
+    QRect highlightRect(const QStyleOptionViewItem &option, int start, int length) const;
+
+    ItemFilter *m_filter;
+    /* highlighted areas by item text */
+    mutable QHash<QString, Highlight> m_highlights;
+};
+
+#endif // ITEMDELEGATE_H
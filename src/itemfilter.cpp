@@ -0,0 +1,839 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "itemfilter.h"
+
+#include "itemmodel.h"
+#include "trace.h"
+
+#include <QElapsedTimer>
+#include <QStringList>
+
+#include <algorithm>
+
+namespace {
+
+struct SortKey {
+    QString text;
+    int row;
+    quint32 span;
+};
+
+class SortKeyLessThan
+{
+public:
+    explicit SortKeyLessThan(Qt::CaseSensitivity cs) : m_cs(cs) {}
+
+    bool operator()(const SortKey &a, const SortKey &b) const
+    {
+        const int cmp = a.text.compare(b.text, m_cs);
+        return cmp < 0 || (cmp == 0 && a.row < b.row);
+    }
+
+private:
+    Qt::CaseSensitivity m_cs;
+};
+
+} // namespace
+
+/* renumber stored rows if offset gets too far from zero */
+static const int max_row_offset = 1 << 30;
+
+/* incremental filtering - rows filtered at once and time spent in single batch */
+static const int filter_batch_rows = 1024;
+static const int filter_batch_ms = 10;
+
+/* match position packed to 32 bits: start (high half) and length (low half) */
+static const quint32 no_span = 0xffffffff;
+
+static quint32 packSpan(int start, int length)
+{
+    if (start < 0 || length <= 0 || start >= 0xffff || length > 0xffff)
+        return no_span;
+    return (static_cast<quint32>(start) << 16) | static_cast<quint32>(length);
+}
+
+static bool longerThan(const QString &a, const QString &b)
+{
+    return a.size() > b.size();
+}
+
+/* skip group or character class starting at given position */
+static int skipGroup(const QString &pattern, int i)
+{
+    int depth = 0;
+    bool inClass = false;
+    for ( ; i < pattern.size(); ++i ) {
+        const QChar c = pattern[i];
+        if (c == '\\') {
+            ++i;
+        } else if (inClass) {
+            if ( c == '[' && i + 1 < pattern.size() && QString(":=.").contains(pattern[i + 1]) ) {
+                /* POSIX class (e.g. "[:digit:]") ends with same character and "]" */
+                const int end = pattern.indexOf( QString(pattern[i + 1]) + ']', i + 2 );
+                if (end != -1)
+                    i = end + 1;
+            } else if (c == ']') {
+                inClass = false;
+            }
+        } else if (c == '[') {
+            inClass = true;
+            /* "]" right after "[" or "[^" is literal */
+            if ( i + 1 < pattern.size() && pattern[i + 1] == '^' )
+                ++i;
+            if ( i + 1 < pattern.size() && pattern[i + 1] == ']' )
+                ++i;
+            if (depth == 0)
+                depth = -1;
+        } else if (c == '(') {
+            ++depth;
+        } else if (c == ')') {
+            if (--depth == 0)
+                return i;
+        }
+
+        if (depth == -1 && !inClass)
+            return i;
+    }
+    return i;
+}
+
+/*
+ * Return literal strings which every match of pattern must contain.
+ * Returns empty list if this is not simple to find out.
+ */
+static QStringList requiredLiterals(const QString &pattern)
+{
+    QStringList literals;
+    QString literal;
+
+    for ( int i = 0; i < pattern.size(); ++i ) {
+        const QChar c = pattern[i];
+
+        if (c == '\\') {
+            if ( i + 1 == pattern.size() )
+                return QStringList();
+            const QChar next = pattern[++i];
+            /*
+             * escapes with arguments (character codes, back references,
+             * properties etc.) - arguments are not literals
+             */
+            if ( next.isDigit() || QString("xocgkpPN").contains(next) )
+                return QStringList();
+            /* character types, assertions etc. */
+            if ( next.isLetter() ) {
+                literals.append(literal);
+                literal.clear();
+            } else {
+                literal.append(next);
+            }
+        } else if (c == '|') {
+            /* alternation at top level */
+            return QStringList();
+        } else if (c == '(' || c == '[') {
+            /* options can change meaning of the rest of pattern */
+            if ( c == '(' && i + 1 < pattern.size() && pattern[i + 1] == '?'
+                 && (i + 2 == pattern.size() || pattern[i + 2] != ':') )
+            {
+                return QStringList();
+            }
+            literals.append(literal);
+            literal.clear();
+            i = skipGroup(pattern, i);
+        } else if (c == '*' || c == '?' || c == '{') {
+            /* previous character is optional */
+            literal.chop(1);
+            literals.append(literal);
+            literal.clear();
+            if (c == '{') {
+                const int end = pattern.indexOf('}', i);
+                if (end == -1)
+                    return QStringList();
+                i = end;
+            }
+        } else if (c == '+' || c == '.' || c == '^' || c == '$') {
+            literals.append(literal);
+            literal.clear();
+        } else {
+            literal.append(c);
+        }
+    }
+    literals.append(literal);
+
+    literals.removeAll(QString());
+    /* longest literals reject most items */
+    std::sort(literals.begin(), literals.end(), longerThan);
+
+    return literals;
+}
+
+/*
+ * Return literal strings which every match of wildcard pattern must contain.
+ * Sets needsWildcard to false if it's enough to search for the literals.
+ */
+static QStringList wildcardLiterals(const QString &pattern, bool *needsWildcard)
+{
+    QStringList literals;
+    QString literal;
+    *needsWildcard = false;
+
+    for ( int i = 0; i < pattern.size(); ++i ) {
+        const QChar c = pattern[i];
+
+        if (c == '*' || c == '?' || c == '[') {
+            literals.append(literal);
+            literal.clear();
+
+            if (c == '[') {
+                /* "]" right after "[" or "[!" is literal */
+                int end = i + 1;
+                if ( end < pattern.size() && (pattern[end] == '!' || pattern[end] == '^') )
+                    ++end;
+                if ( end < pattern.size() && pattern[end] == ']' )
+                    ++end;
+                end = pattern.indexOf(']', end);
+                if (end == -1) {
+                    *needsWildcard = true;
+                    break;
+                }
+                i = end;
+            }
+
+            if (c != '*')
+                *needsWildcard = true;
+        } else {
+            literal.append(c);
+        }
+    }
+    literals.append(literal);
+
+    literals.removeAll(QString());
+
+    /* order of literals matters */
+    if ( literals.size() > 1 )
+        *needsWildcard = true;
+
+    std::sort(literals.begin(), literals.end(), longerThan);
+
+    return literals;
+}
+
+ItemFilter::ItemFilter(QObject *parent)
+    : QAbstractProxyModel(parent)
+    , m_base(0)
+    , m_itemModel(NULL)
+    , m_sorted(false)
+    , m_filterRole(Qt::DisplayRole)
+    , m_filterCaseSensitivity(Qt::CaseSensitive)
+    , m_sortCaseSensitivity(Qt::CaseSensitive)
+    , m_incremental(false)
+    , m_unfiltered(-1)
+    , m_regex(false)
+    , m_wildcardNeeded(false)
+    , m_signature(0)
+{
+    m_timerFilter.setSingleShot(true);
+    m_timerFilter.setInterval(0);
+    connect( &m_timerFilter, SIGNAL(timeout()),
+             this, SLOT(filterNext()) );
+}
+
+void ItemFilter::setSourceModel(QAbstractItemModel *sourceModel)
+{
+    beginResetModel();
+
+    if ( this->sourceModel() )
+        disconnect( this->sourceModel(), 0, this, 0 );
+
+    QAbstractProxyModel::setSourceModel(sourceModel);
+    m_itemModel = qobject_cast<ItemModel*>(sourceModel);
+
+    if (sourceModel) {
+        connect( sourceModel, SIGNAL(rowsInserted(QModelIndex,int,int)),
+                 this, SLOT(sourceRowsInserted(QModelIndex,int,int)) );
+        connect( sourceModel, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)),
+                 this, SLOT(sourceRowsAboutToBeRemoved(QModelIndex,int,int)) );
+        connect( sourceModel, SIGNAL(rowsRemoved(QModelIndex,int,int)),
+                 this, SLOT(sourceRowsRemoved(QModelIndex,int,int)) );
+        connect( sourceModel, SIGNAL(modelAboutToBeReset()),
+                 this, SLOT(sourceAboutToBeReset()) );
+        connect( sourceModel, SIGNAL(modelReset()),
+                 this, SLOT(sourceReset()) );
+    }
+
+    resetRows();
+
+    endResetModel();
+}
+
+bool ItemFilter::setPattern(const QString &pattern)
+{
+    TRACE_SPAN("ItemFilter::setPattern");
+
+    /* rows are already filtered (or being filtered) with the pattern */
+    if (pattern == m_pattern) {
+        m_errorString.clear();
+        return true;
+    }
+
+    QStringList literals;
+
+    if (m_regex) {
+        QRegularExpression::PatternOptions options = QRegularExpression::NoPatternOption;
+        if (m_filterCaseSensitivity == Qt::CaseInsensitive)
+            options |= QRegularExpression::CaseInsensitiveOption;
+
+        QRegularExpression re(pattern, options);
+        if ( !re.isValid() ) {
+            m_errorString = re.errorString();
+            return false;
+        }
+        m_errorString.clear();
+
+        /* compile (using JIT if available) once and not for each item */
+#if QT_VERSION >= QT_VERSION_CHECK(5,4,0)
+        re.optimize();
+#endif
+        m_re = re;
+        literals = requiredLiterals(pattern);
+    } else {
+        m_wildcard = QRegExp(pattern, m_filterCaseSensitivity, QRegExp::Wildcard);
+        literals = wildcardLiterals(pattern, &m_wildcardNeeded);
+    }
+
+    m_pattern = pattern;
+    m_literals.clear();
+    m_signature = 0;
+    foreach ( const QString &literal, literals ) {
+        m_literals.append( QStringMatcher(literal, m_filterCaseSensitivity) );
+        m_signature |= textSignature(literal);
+    }
+
+    if ( !sourceModel() )
+        return true;
+
+    m_timerFilter.stop();
+
+    if (m_incremental) {
+        setRows( QVector<int>(), QVector<quint32>() );
+        m_unfiltered = 0;
+        m_timerFilter.start();
+    } else {
+        m_unfiltered = -1;
+        QVector<quint32> spans;
+        QVector<int> rows = filterRows( 0, sourceModel()->rowCount() - 1, &spans );
+        if (m_sorted)
+            sortRows(&rows, &spans);
+        setRows(rows, spans);
+    }
+
+    return true;
+}
+
+void ItemFilter::setIncremental(bool enable)
+{
+    m_incremental = enable;
+    if (!enable)
+        finishFiltering();
+}
+
+void ItemFilter::finishFiltering()
+{
+    if (m_unfiltered == -1)
+        return;
+
+    TRACE_SPAN("ItemFilter::finishFiltering");
+
+    m_timerFilter.stop();
+    QVector<quint32> spans;
+    const QVector<int> rows = filterRows( m_unfiltered, sourceModel()->rowCount() - 1, &spans );
+    m_unfiltered = -1;
+    addRows(rows, spans);
+
+    emit filterFinished();
+}
+
+void ItemFilter::sort(int column, Qt::SortOrder order)
+{
+    TRACE_SPAN("ItemFilter::sort");
+
+    /* only ascending order is used */
+    Q_UNUSED(order);
+
+    m_sorted = column == 0;
+
+    QVector<int> rows = m_rows;
+    QVector<quint32> spans = m_spans;
+    sortRows(&rows, &spans);
+    setRows(rows, spans);
+}
+
+QModelIndex ItemFilter::mapToSource(const QModelIndex &proxyIndex) const
+{
+    if ( !proxyIndex.isValid() || !sourceModel() || proxyIndex.row() >= m_rows.size() )
+        return QModelIndex();
+    return sourceModel()->index( m_rows[proxyIndex.row()] - m_base, proxyIndex.column() );
+}
+
+QModelIndex ItemFilter::mapFromSource(const QModelIndex &sourceIndex) const
+{
+    if ( !sourceIndex.isValid() )
+        return QModelIndex();
+
+    const int row = sourceIndex.row() + m_base;
+    int proxyRow = -1;
+
+    if (m_sorted) {
+        if ( m_proxyRows.isEmpty() ) {
+            m_proxyRows.fill( -1, sourceModel()->rowCount() );
+            for ( int i = 0; i < m_rows.size(); ++i )
+                m_proxyRows[ m_rows[i] - m_base ] = i;
+        }
+        proxyRow = m_proxyRows.value( sourceIndex.row(), -1 );
+    } else {
+        QVector<int>::const_iterator it = std::lower_bound( m_rows.begin(), m_rows.end(), row );
+        if ( it != m_rows.end() && *it == row )
+            proxyRow = it - m_rows.begin();
+    }
+
+    return proxyRow == -1 ? QModelIndex() : createIndex( proxyRow, sourceIndex.column() );
+}
+
+QModelIndex ItemFilter::index(int row, int column, const QModelIndex &parent) const
+{
+    if ( parent.isValid() || row < 0 || row >= m_rows.size() || column != 0 )
+        return QModelIndex();
+    return createIndex(row, column);
+}
+
+QModelIndex ItemFilter::parent(const QModelIndex &) const
+{
+    return QModelIndex();
+}
+
+int ItemFilter::rowCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : m_rows.size();
+}
+
+int ItemFilter::columnCount(const QModelIndex &parent) const
+{
+    return parent.isValid() ? 0 : 1;
+}
+
+bool ItemFilter::hasChildren(const QModelIndex &parent) const
+{
+    return !parent.isValid() && !m_rows.isEmpty();
+}
+
+void ItemFilter::sourceRowsInserted(const QModelIndex &parent, int first, int last)
+{
+    if ( parent.isValid() )
+        return;
+
+    /* rows will be filtered later */
+    if (m_unfiltered != -1 && first >= m_unfiltered)
+        return;
+
+    TRACE_SPAN("ItemFilter::sourceRowsInserted");
+
+    /* move rows after inserted ones (nothing to do when appending) */
+    const int count = last - first + 1;
+    if (m_unfiltered != -1)
+        m_unfiltered += count;
+    if (first == 0) {
+        m_base -= count;
+    } else if ( first + count < sourceModel()->rowCount() ) {
+        QVector<int>::iterator it = m_sorted
+                ? m_rows.begin()
+                : std::lower_bound( m_rows.begin(), m_rows.end(), first + m_base );
+        for ( ; it != m_rows.end(); ++it ) {
+            if (*it >= first + m_base)
+                *it += count;
+        }
+    }
+    m_proxyRows.clear();
+
+    /* filter only new rows */
+    QVector<quint32> spans;
+    QVector<int> rows = filterRows(first, last, &spans);
+    normalizeRows(&rows);
+    addRows(rows, spans);
+}
+
+void ItemFilter::addRows(QVector<int> rows, QVector<quint32> spans)
+{
+    if ( rows.isEmpty() )
+        return;
+
+    if (m_sorted) {
+        sortRows(&rows, &spans);
+
+        /* positions in current result (found before anything is inserted) */
+        QVector<int> positions;
+        positions.reserve( rows.size() );
+        int pos = 0;
+        foreach (int row, rows) {
+            pos = sortedPosition(row, pos);
+            positions.append(pos);
+        }
+
+        /* insert runs of rows with the same position from the end so earlier positions don't change */
+        int end = rows.size();
+        while (end > 0) {
+            const int row = positions[end - 1];
+            int begin = end - 1;
+            while ( begin > 0 && positions[begin - 1] == row )
+                --begin;
+
+            beginInsertRows( QModelIndex(), row, row + end - begin - 1 );
+            m_rows.insert( row, end - begin, 0 );
+            std::copy( rows.begin() + begin, rows.begin() + end, m_rows.begin() + row );
+            m_spans.insert( row, end - begin, 0 );
+            std::copy( spans.begin() + begin, spans.begin() + end, m_spans.begin() + row );
+            m_proxyRows.clear();
+            endInsertRows();
+
+            end = begin;
+        }
+        return;
+    }
+
+    const int row = std::lower_bound( m_rows.begin(), m_rows.end(), rows.first() ) - m_rows.begin();
+    beginInsertRows( QModelIndex(), row, row + rows.size() - 1 );
+    if ( row == m_rows.size() ) {
+        m_rows += rows;
+        m_spans += spans;
+    } else {
+        m_rows.insert( row, rows.size(), 0 );
+        std::copy( rows.begin(), rows.end(), m_rows.begin() + row );
+        m_spans.insert( row, spans.size(), 0 );
+        std::copy( spans.begin(), spans.end(), m_spans.begin() + row );
+    }
+    endInsertRows();
+}
+
+void ItemFilter::sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last)
+{
+    if ( parent.isValid() )
+        return;
+
+    TRACE_SPAN("ItemFilter::sourceRowsAboutToBeRemoved");
+
+    if (m_sorted) {
+        QVector<int> rows;
+        QVector<quint32> spans;
+        rows.reserve( m_rows.size() );
+        spans.reserve( m_spans.size() );
+        for ( int i = 0; i < m_rows.size(); ++i ) {
+            const int row = m_rows[i];
+            if (row < first + m_base || row > last + m_base) {
+                rows.append(row);
+                spans.append(m_spans[i]);
+            }
+        }
+        if ( rows.size() != m_rows.size() )
+            setRows(rows, spans);
+        return;
+    }
+
+    const int from = std::lower_bound( m_rows.begin(), m_rows.end(), first + m_base ) - m_rows.begin();
+    const int to = std::lower_bound( m_rows.begin(), m_rows.end(), last + m_base + 1 ) - m_rows.begin();
+    if (from == to)
+        return;
+
+    beginRemoveRows(QModelIndex(), from, to - 1);
+    m_rows.remove(from, to - from);
+    m_spans.remove(from, to - from);
+    endRemoveRows();
+}
+
+void ItemFilter::sourceRowsRemoved(const QModelIndex &parent, int first, int last)
+{
+    if ( parent.isValid() )
+        return;
+
+    /* move rows after removed ones (only offset changes if oldest items are removed) */
+    const int count = last - first + 1;
+    if (m_unfiltered != -1 && first < m_unfiltered)
+        m_unfiltered -= qMin(last + 1, m_unfiltered) - first;
+    if (first == 0) {
+        m_base += count;
+    } else {
+        QVector<int>::iterator it = m_sorted
+                ? m_rows.begin()
+                : std::lower_bound( m_rows.begin(), m_rows.end(), first + m_base );
+        for ( ; it != m_rows.end(); ++it ) {
+            if (*it > last + m_base)
+                *it -= count;
+        }
+    }
+    m_proxyRows.clear();
+
+    normalizeRows(NULL);
+}
+
+void ItemFilter::sourceAboutToBeReset()
+{
+    beginResetModel();
+}
+
+void ItemFilter::sourceReset()
+{
+    resetRows();
+    endResetModel();
+}
+
+void ItemFilter::filterNext()
+{
+    if (m_unfiltered == -1)
+        return;
+
+    TRACE_SPAN("ItemFilter::filterNext");
+
+    QElapsedTimer elapsed;
+    elapsed.start();
+
+    const int count = sourceModel()->rowCount();
+    QVector<int> rows;
+    QVector<quint32> spans;
+    int row = m_unfiltered;
+    do {
+        const int last = qMin(row + filter_batch_rows, count) - 1;
+        rows += filterRows(row, last, &spans);
+        row = last + 1;
+    } while ( row < count && elapsed.elapsed() < filter_batch_ms );
+
+    /* continue later so user input is not blocked */
+    if (row < count) {
+        m_unfiltered = row;
+        m_timerFilter.start();
+    } else {
+        m_unfiltered = -1;
+    }
+
+    addRows(rows, spans);
+
+    if (m_unfiltered == -1)
+        emit filterFinished();
+}
+
+bool ItemFilter::filterAcceptsRow(int sourceRow, quint32 *span) const
+{
+    *span = no_span;
+
+    if ( m_literals.isEmpty() && (m_regex ? m_re.pattern().isEmpty() : !m_wildcardNeeded) )
+        return true;
+
+    const QString text = sourceModel()->index(sourceRow, 0).data(m_filterRole).toString();
+
+    int start = -1;
+    int length = 0;
+    foreach (const QStringMatcher &matcher, m_literals) {
+        const int i = matcher.indexIn(text);
+        if (i == -1)
+            return false;
+        if (start == -1) {
+            start = i;
+            length = matcher.pattern().size();
+        }
+    }
+
+    if (m_regex) {
+        const QRegularExpressionMatch match = m_re.match(text);
+        if ( !match.hasMatch() )
+            return false;
+        start = match.capturedStart();
+        length = match.capturedLength();
+    } else if (m_wildcardNeeded) {
+        start = m_wildcard.indexIn(text);
+        if (start == -1)
+            return false;
+        length = m_wildcard.matchedLength();
+    }
+
+    *span = packSpan(start, length);
+    return true;
+}
+
+bool ItemFilter::matchSpan(const QModelIndex &proxyIndex, int *start, int *length) const
+{
+    if ( m_pattern.isEmpty() || !proxyIndex.isValid() || proxyIndex.row() >= m_rows.size() )
+        return false;
+
+    /* filtered text must be the displayed text */
+    if ( m_filterRole != Qt::DisplayRole
+         && (!m_itemModel || m_filterRole != ItemModel::FilterRole
+             || m_itemModel->field(ItemModel::FilterField) != m_itemModel->field(ItemModel::DisplayField)) )
+    {
+        return false;
+    }
+
+    const quint32 span = m_spans[proxyIndex.row()];
+    if (span == no_span)
+        return false;
+
+    *start = span >> 16;
+    *length = span & 0xffff;
+    return true;
+}
+
+QVector<int> ItemFilter::filterRows(int first, int last, QVector<quint32> *spans) const
+{
+    QVector<int> rows;
+    quint32 span;
+
+    if ( m_signature == 0 || !m_itemModel || m_filterRole != ItemModel::FilterRole ) {
+        for (int row = first; row <= last; ++row) {
+            if ( filterAcceptsRow(row, &span) ) {
+                rows.append(row + m_base);
+                spans->append(span);
+            }
+        }
+        return rows;
+    }
+
+    /* reject most rows without accessing item text */
+    QVector<int> candidates;
+    m_itemModel->candidateRows(m_signature, first, last, &candidates);
+    foreach (int row, candidates) {
+        if ( filterAcceptsRow(row, &span) ) {
+            rows.append(row + m_base);
+            spans->append(span);
+        }
+    }
+
+    if (trace_flags && first <= last) {
+        const int count = last - first + 1;
+        traceCounter( "ItemFilter rows rejected by signature (%)",
+                      100 * (count - candidates.size()) / count );
+    }
+
+    return rows;
+}
+
+void ItemFilter::resetRows()
+{
+    m_base = 0;
+    m_proxyRows.clear();
+    m_rows.clear();
+    m_spans.clear();
+    m_unfiltered = -1;
+    m_timerFilter.stop();
+
+    if ( !sourceModel() )
+        return;
+
+    if (m_incremental) {
+        m_unfiltered = 0;
+        m_timerFilter.start();
+    } else {
+        m_rows = filterRows( 0, sourceModel()->rowCount() - 1, &m_spans );
+        if (m_sorted)
+            sortRows(&m_rows, &m_spans);
+    }
+}
+
+void ItemFilter::normalizeRows(QVector<int> *rows)
+{
+    if ( qAbs(m_base) < max_row_offset )
+        return;
+
+    for ( QVector<int>::iterator it = m_rows.begin(); it != m_rows.end(); ++it )
+        *it -= m_base;
+
+    if (rows) {
+        for ( QVector<int>::iterator it = rows->begin(); it != rows->end(); ++it )
+            *it -= m_base;
+    }
+
+    m_base = 0;
+}
+
+void ItemFilter::sortRows(QVector<int> *rows, QVector<quint32> *spans) const
+{
+    QVector<SortKey> keys;
+    keys.reserve( rows->size() );
+    for ( int i = 0; i < rows->size(); ++i ) {
+        SortKey key;
+        key.row = (*rows)[i];
+        key.span = (*spans)[i];
+        if (m_sorted)
+            key.text = sortText(key.row - m_base);
+        keys.append(key);
+    }
+
+    /* keys without text are sorted by row */
+    std::sort( keys.begin(), keys.end(), SortKeyLessThan(m_sortCaseSensitivity) );
+
+    for ( int i = 0; i < keys.size(); ++i ) {
+        (*rows)[i] = keys[i].row;
+        (*spans)[i] = keys[i].span;
+    }
+}
+
+int ItemFilter::sortedPosition(int row, int from) const
+{
+    const QString text = sortText(row - m_base);
+
+    int to = m_rows.size();
+    while (from < to) {
+        const int middle = from + (to - from) / 2;
+        const int other = m_rows[middle];
+        const int cmp = sortText(other - m_base).compare(text, m_sortCaseSensitivity);
+        if ( cmp < 0 || (cmp == 0 && other < row) )
+            from = middle + 1;
+        else
+            to = middle;
+    }
+
+    return from;
+}
+
+QString ItemFilter::sortText(int sourceRow) const
+{
+    return sourceModel()->index(sourceRow, 0).data(Qt::DisplayRole).toString();
+}
+
+void ItemFilter::setRows(const QVector<int> &rows, const QVector<quint32> &spans)
+{
+    emit layoutAboutToBeChanged();
+
+    /* new positions of source rows */
+    QVector<int> proxyRows( sourceModel() ? sourceModel()->rowCount() : 0, -1 );
+    for ( int i = 0; i < rows.size(); ++i )
+        proxyRows[ rows[i] - m_base ] = i;
+
+    const QModelIndexList from = persistentIndexList();
+    QModelIndexList to;
+    foreach (const QModelIndex &index, from) {
+        const int row = proxyRows.value( m_rows.value(index.row(), m_base - 1) - m_base, -1 );
+        to.append( row == -1 ? QModelIndex() : createIndex(row, index.column()) );
+    }
+    changePersistentIndexList(from, to);
+
+    m_rows = rows;
+    m_spans = spans;
+    if (m_sorted)
+        m_proxyRows = proxyRows;
+    else
+        m_proxyRows.clear();
+
+    emit layoutChanged();
+}
@@ -0,0 +1,172 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef ITEMFILTER_H
+#define ITEMFILTER_H
+
+#include <QAbstractProxyModel>
+#include <QRegExp>
+#include <QRegularExpression>
+#include <QStringMatcher>
+#include <QTimer>
+#include <QVector>
+
+class ItemModel;
+
+/*
+ * Filters items using wildcards (default) or regular expressions.
+ *
+ * Regular expression is compiled once per pattern. Literal substrings
+ * required by the pattern are searched first, so most items are rejected
+ * without running the regular expression engine. Before that, items
+ * without all characters of the literals are rejected just by comparing
+ * precomputed character signatures (see ItemModel::candidateRows()).
+ *
+ * Rows added to source model are filtered with current pattern and
+ * appended to result without touching rows filtered earlier, so reading
+ * input costs only as much as the number of new items.
+ *
+ * Position of match in each accepted row is kept until pattern changes
+ * so it can be highlighted without searching item text again.
+ */
+class ItemFilter : public QAbstractProxyModel
+{
+    Q_OBJECT
+public:
+    explicit ItemFilter(QObject *parent = NULL);
+
+    void setSourceModel(QAbstractItemModel *sourceModel);
+
+    void setRegexMode(bool enable) { m_regex = enable; }
+
+    void setFilterRole(int role) { m_filterRole = role; }
+    void setFilterCaseSensitivity(Qt::CaseSensitivity cs) { m_filterCaseSensitivity = cs; }
+    void setSortCaseSensitivity(Qt::CaseSensitivity cs) { m_sortCaseSensitivity = cs; }
+
+    /* returns false (and keeps current filter) if pattern is not valid */
+    bool setPattern(const QString &pattern);
+
+    QString errorString() const { return m_errorString; }
+
+    /*
+     * Filter rows in small batches from event loop instead of all at once
+     * (accepted rows are added to result as they are found).
+     */
+    void setIncremental(bool enable);
+
+    /* filter rows skipped so far by incremental filtering */
+    void finishFiltering();
+
+    /* incremental filtering is not finished */
+    bool isFiltering() const { return m_unfiltered != -1; }
+
+    /*
+     * Matched part of displayed text (returns false if nothing should be
+     * highlighted, e.g. if items are filtered by other field).
+     */
+    bool matchSpan(const QModelIndex &proxyIndex, int *start, int *length) const;
+
+    /* sort items by text; items added later are kept sorted */
+    void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
+
+    QModelIndex mapToSource(const QModelIndex &proxyIndex) const;
+    QModelIndex mapFromSource(const QModelIndex &sourceIndex) const;
+
+    QModelIndex index(int row, int column, const QModelIndex &parent = QModelIndex()) const;
+    QModelIndex parent(const QModelIndex &child) const;
+    int rowCount(const QModelIndex &parent = QModelIndex()) const;
+    int columnCount(const QModelIndex &parent = QModelIndex()) const;
+    bool hasChildren(const QModelIndex &parent = QModelIndex()) const;
+
+signals:
+    /* all rows were filtered incrementally */
+    void filterFinished();
+
+private slots:
+    void sourceRowsInserted(const QModelIndex &parent, int first, int last);
+    void sourceRowsAboutToBeRemoved(const QModelIndex &parent, int first, int last);
+    void sourceRowsRemoved(const QModelIndex &parent, int first, int last);
+    void sourceAboutToBeReset();
+    void sourceReset();
+    void filterNext();
+
+private:
+    /* span is set to packed match position (see packSpan()) */
+    bool filterAcceptsRow(int sourceRow, quint32 *span) const;
+
+    /*
+     * Source rows in range accepted by filter (offset by m_base).
+     * Match positions are appended to spans.
+     */
+    QVector<int> filterRows(int first, int last, QVector<quint32> *spans) const;
+
+    void resetRows();
+
+    /* add accepted rows (offset by m_base) to result */
+    void addRows(QVector<int> rows, QVector<quint32> spans);
+
+    /* renumber rows if m_base is too big */
+    void normalizeRows(QVector<int> *rows);
+
+    /* sort by text if sorted, otherwise by row (spans are moved with rows) */
+    void sortRows(QVector<int> *rows, QVector<quint32> *spans) const;
+
+    /* position in sorted result for new row (searched from given position) */
+    int sortedPosition(int row, int from) const;
+
+    QString sortText(int sourceRow) const;
+
+    /* replace result (keeps selected and current items if still accepted) */
+    void setRows(const QVector<int> &rows, const QVector<quint32> &spans);
+
+    /*
+     * Accepted source rows offset by m_base, so removing oldest items
+     * from source model doesn't require renumbering all rows.
+     */
+    QVector<int> m_rows;
+    int m_base;
+    /* packed match positions found while filtering (same order as m_rows) */
+    QVector<quint32> m_spans;
+    /* source model with item signatures */
+    ItemModel *m_itemModel;
+    /* source row to proxy row (only if sorted) */
+    mutable QVector<int> m_proxyRows;
+    bool m_sorted;
+
+    int m_filterRole;
+    Qt::CaseSensitivity m_filterCaseSensitivity;
+    Qt::CaseSensitivity m_sortCaseSensitivity;
+
+    bool m_incremental;
+    /* first source row not yet filtered or -1 */
+    int m_unfiltered;
+    QTimer m_timerFilter;
+
+    QString m_pattern;
+    bool m_regex;
+    QRegularExpression m_re;
+    QRegExp m_wildcard;
+    bool m_wildcardNeeded;
+    QVector<QStringMatcher> m_literals;
+    /* characters required by pattern */
+    quint64 m_signature;
+    QString m_errorString;
+};
+
+#endif // ITEMFILTER_H
@@ -19,16 +19,116 @@
 
 #include "itemmodel.h"
 
+#include "trace.h"
+
 #include <QApplication>
 #include <QFileIconProvider>
 #include <QFont>
+#include <QPair>
 #include <QPalette>
-#include <QStringList>
 
+#include <algorithm>
+#include <cerrno>
 #include <cstdio>
+#include <cstring>
 #include <unistd.h>
 
-static const int stdin_batch_size = 250;
+/* read stdin in chunks */
+static const int stdin_chunk_size = 64 * 1024;
+/* maximum number of chunks read before returning to event loop */
+static const int stdin_batch_size = 16;
+
+/* replace whole list if frames differ more */
+static const int frame_max_edits = 1000;
+
+typedef QPair<int, int> Match;
+
+/*
+ * Find longest common subsequence of old and new items using Myers'
+ * difference algorithm. Matching rows are stored as pairs (old, new).
+ * Returns false if lists differ in more than max_edits items.
+ */
+static bool commonItems(const QVector<Item> &a, const QVector<Item> &b,
+                        int max_edits, QVector<Match> *common)
+{
+    const int n = a.size();
+    const int m = b.size();
+    const int max = qMin(n + m, max_edits);
+    const int offset = max + 1;
+
+    QVector<int> v(2 * max + 3, 0);
+    QVector< QVector<int> > trace;
+
+    for (int d = 0; d <= max; ++d) {
+        trace.append(v);
+        for (int k = -d; k <= d; k += 2) {
+            int x;
+            if ( k == -d || (k != d && v[offset + k - 1] < v[offset + k + 1]) )
+                x = v[offset + k + 1];
+            else
+                x = v[offset + k - 1] + 1;
+            int y = x - k;
+
+            while ( x < n && y < m && a[x] == b[y] ) {
+                ++x;
+                ++y;
+            }
+            v[offset + k] = x;
+
+            if (x < n || y < m)
+                continue;
+
+            /* backtrack to collect diagonals (matching items) */
+            for (int e = d; e >= 0; --e) {
+                const QVector<int> &w = trace[e];
+                const int kk = x - y;
+                const int prev_k = (kk == -e || (kk != e && w[offset + kk - 1] < w[offset + kk + 1]))
+                        ? kk + 1 : kk - 1;
+                const int prev_x = w[offset + prev_k];
+                const int prev_y = prev_x - prev_k;
+
+                while (x > prev_x && y > prev_y) {
+                    --x;
+                    --y;
+                    common->append( Match(x, y) );
+                }
+
+                x = prev_x;
+                y = prev_y;
+            }
+            std::reverse( common->begin(), common->end() );
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/* signatures are tested in blocks without branching (can be vectorized) */
+static void appendCandidates(
+        const quint64 *signatures, int size, quint64 signature, int row, QVector<int> *rows)
+{
+    int i = 0;
+    for ( ; i + 8 <= size; i += 8 ) {
+        uint found = 0;
+        for (int j = 0; j < 8; ++j)
+            found |= uint( (signatures[i + j] & signature) == signature ) << j;
+
+        if (found == 0)
+            continue;
+
+        for (int j = 0; j < 8; ++j) {
+            if ( found & (1u << j) )
+                rows->append(row + i + j);
+        }
+    }
+
+    for ( ; i < size; ++i ) {
+        if ( (signatures[i] & signature) == signature )
+            rows->append(row + i);
+    }
+}
 
 static void initSingleShotTimer(
         QTimer *timer, int msecs, const QObject *receiver, const char *slot)
@@ -42,9 +142,16 @@ static void initSingleShotTimer(
 ItemModel::ItemModel(QObject *parent)
     : QAbstractListModel(parent)
     , m_count(0)
+    , m_first(0)
+    , m_tail(0)
+    , m_frames(false)
+    , m_stdinClosed(false)
+    , m_delimiter('\t')
 {
-    /* no buffer for stdin */
-    setbuf(stdin, NULL);
+    for (int i = 0; i < FieldUsageCount; ++i) {
+        m_fieldNumber[i] = 0;
+        m_fieldIndex[i] = -1;
+    }
 
     /* fetch lines from stdin - doesn't block application */
     initSingleShotTimer(&m_timerFetch, 0, this, SLOT(readStdin()));
@@ -63,13 +170,17 @@ QVariant ItemModel::data(const QModelIndex &index, int role) const
     int row = index.row();
 
     if (role == Qt::DisplayRole || role == Qt::EditRole)
-        return m_items.at(row);
+        return itemText(row);
+
+    if (role == FilterRole)
+        return fieldText(row, FilterField);
 
     if (role == Qt::SizeHintRole)
         return m_itemSize;
 
     if (role == Qt::DecorationRole) {
-        QFileInfo info( m_items.at(row) );
+        TRACE_SPAN("ItemModel::data (icon)");
+        QFileInfo info( m_baseDir, itemText(row) );
         if ( info.exists() ) {
             QIcon icon = icon_provider.icon(info);
             return icon;
@@ -84,18 +195,371 @@ void ItemModel::setItemSize(QSize &size)
     m_itemSize = size;
 }
 
+void ItemModel::setTailSize(int size)
+{
+    m_tail = size;
+    if (m_tail > 0) {
+        m_items.reserve(m_tail);
+        m_signatures.reserve(m_tail);
+    }
+}
+
+void ItemModel::closeStdin()
+{
+    m_timerFetch.stop();
+    m_stdinClosed = true;
+}
+
+void ItemModel::clear()
+{
+    beginResetModel();
+    m_items.clear();
+    m_fields.clear();
+    m_signatures.clear();
+    m_pending.clear();
+    m_line.clear();
+    m_count = 0;
+    m_first = 0;
+    endResetModel();
+}
+
+void ItemModel::addItems(const QByteArray &lines)
+{
+    addData( lines.constData(), lines.size() );
+
+    /* publish new items */
+    if ( !m_timerUpdate.isActive() )
+        m_timerUpdate.start();
+}
+
+void ItemModel::addItems(const QVector<Item> &items)
+{
+    m_pending += items;
+
+    if ( !m_timerUpdate.isActive() )
+        m_timerUpdate.start();
+}
+
+void ItemModel::setItems(const QByteArray &lines)
+{
+    QVector<Item> items;
+    const char *data = lines.constData();
+    const char *end = data + lines.size();
+
+    while (data < end) {
+        const char *eol = static_cast<const char *>( memchr(data, '\n', end - data) );
+        if (!eol)
+            eol = end;
+        items.append( Item(data, eol - data) );
+        data = eol + 1;
+    }
+
+    replaceItems(items);
+}
+
+void ItemModel::setField(FieldUsage usage, int number)
+{
+    m_fieldNumber[usage] = number;
+
+    /* spans are stored only for used fields */
+    m_fieldNumbers.clear();
+    for (int i = 0; i < FieldUsageCount; ++i) {
+        if ( m_fieldNumber[i] > 0 && !m_fieldNumbers.contains(m_fieldNumber[i]) )
+            m_fieldNumbers.append( m_fieldNumber[i] );
+    }
+    std::sort( m_fieldNumbers.begin(), m_fieldNumbers.end() );
+
+    for (int i = 0; i < FieldUsageCount; ++i)
+        m_fieldIndex[i] = m_fieldNumbers.indexOf( m_fieldNumber[i] );
+}
+
+int ItemModel::indexOf(const QString &text) const
+{
+    if ( m_fieldIndex[DisplayField] != -1 ) {
+        for (int row = 0; row < m_count; ++row) {
+            if ( itemText(row) == text )
+                return row;
+        }
+        return -1;
+    }
+
+    const QByteArray bytes = text.toUtf8();
+    for (int row = 0; row < m_count; ++row) {
+        const Item &item = m_items.at( slot(row) );
+        if ( item.encoding() == Item::Local8Bit ? item.text() == text : item.bytes() == bytes )
+            return row;
+    }
+    return -1;
+}
+
+QChar ItemModel::firstChar(int row) const
+{
+    const int i = slot(row);
+    const Item &item = m_items.at(i);
+    const int field = m_fieldIndex[DisplayField];
+    int start = 0;
+    int size = item.bytes().size();
+    if (field != -1) {
+        const FieldSpan &span = m_fields.at( i * m_fieldNumbers.size() + field );
+        start = span.start;
+        size = span.size;
+    }
+
+    if (size == 0)
+        return QChar();
+
+    const uchar c = item.bytes().at(start);
+    if (c < 0x80)
+        return QChar(c);
+
+    /* encoded character has at most 4 bytes */
+    const QString text = item.text( start, qMin(size, 4) );
+    return text.isEmpty() ? QChar() : text[0];
+}
+
+QByteArray ItemModel::itemBytes(int row) const
+{
+    const int i = slot(row);
+    const Item &item = m_items.at(i);
+    const int field = m_fieldIndex[OutputField];
+    if (field == -1)
+        return item.bytes();
+
+    const FieldSpan &span = m_fields.at( i * m_fieldNumbers.size() + field );
+    return item.bytes().mid(span.start, span.size);
+}
+
+void ItemModel::candidateRows(quint64 signature, int first, int last, QVector<int> *rows) const
+{
+    const int size = m_tail > 0 ? m_tail : m_signatures.size();
+    int row = first;
+    while (row <= last) {
+        /* rows in ring buffer are stored in at most two parts */
+        const int i = slot(row);
+        const int count = qMin(last - row + 1, size - i);
+        appendCandidates(m_signatures.constData() + i, count, signature, row, rows);
+        row += count;
+    }
+}
+
+QString ItemModel::fieldText(int row, FieldUsage usage) const
+{
+    const int i = slot(row);
+    const Item &item = m_items.at(i);
+    const int field = m_fieldIndex[usage];
+    if (field == -1)
+        return item.text();
+
+    const FieldSpan &span = m_fields.at( i * m_fieldNumbers.size() + field );
+    return item.text(span.start, span.size);
+}
+
+void ItemModel::setItem(int slot, const Item &item)
+{
+    if ( slot == m_items.size() ) {
+        m_items.append(item);
+        m_fields.resize( m_fields.size() + m_fieldNumbers.size() );
+        m_signatures.append(0);
+    } else {
+        m_items[slot] = item;
+    }
+    storeFields(slot);
+    storeSignature(slot);
+}
+
+void ItemModel::storeFields(int slot)
+{
+    const int count = m_fieldNumbers.size();
+    if (count == 0)
+        return;
+
+    const QByteArray &bytes = m_items.at(slot).bytes();
+    const char *data = bytes.constData();
+    const int size = bytes.size();
+    FieldSpan *spans = m_fields.data() + slot * count;
+
+    int number = 1;
+    int start = 0;
+    int j = 0;
+    while (j < count) {
+        const char *end = static_cast<const char *>(
+                    memchr(data + start, m_delimiter, size - start) );
+        const int stop = end ? end - data : size;
+
+        if ( m_fieldNumbers[j] == number ) {
+            spans[j] = FieldSpan(start, stop - start);
+            ++j;
+        }
+
+        if (!end)
+            break;
+
+        start = stop + 1;
+        ++number;
+    }
+
+    /* missing fields are empty */
+    for ( ; j < count; ++j )
+        spans[j] = FieldSpan(size, 0);
+}
+
+void ItemModel::storeSignature(int slot)
+{
+    const QByteArray &bytes = m_items.at(slot).bytes();
+    const int field = m_fieldIndex[FilterField];
+    if (field == -1) {
+        m_signatures[slot] = textSignature( bytes.constData(), bytes.size() );
+    } else {
+        const FieldSpan &span = m_fields.at( slot * m_fieldNumbers.size() + field );
+        m_signatures[slot] = textSignature( bytes.constData() + span.start, span.size );
+    }
+}
+
+int ItemModel::slot(int row) const
+{
+    if (m_tail <= 0)
+        return row;
+
+    const int i = m_first + row;
+    return i < m_tail ? i : i - m_tail;
+}
+
+void ItemModel::removeOldest(int rows)
+{
+    TRACE_SPAN("ItemModel::removeOldest");
+
+    beginRemoveRows(QModelIndex(), 0, rows - 1);
+    /* release evicted items, slots are reused by new items */
+    for (int row = 0; row < rows; ++row)
+        m_items[ slot(row) ] = Item();
+    m_first = slot(rows);
+    m_count -= rows;
+    endRemoveRows();
+}
+
+void ItemModel::endFrame()
+{
+    replaceItems(m_pending);
+    m_pending.clear();
+}
+
+void ItemModel::replaceItems(const QVector<Item> &items)
+{
+    TRACE_SPAN("ItemModel::replaceItems");
+
+    /* ring buffer is not used with frames */
+    if (m_tail > 0) {
+        const int count = m_fieldNumbers.size();
+        QVector<Item> linear;
+        QVector<FieldSpan> fields;
+        QVector<quint64> signatures;
+        linear.reserve(m_count);
+        fields.reserve(m_count * count);
+        signatures.reserve(m_count);
+        for (int row = 0; row < m_count; ++row) {
+            const int i = slot(row);
+            linear.append( m_items.at(i) );
+            for (int j = 0; j < count; ++j)
+                fields.append( m_fields.at(i * count + j) );
+            signatures.append( m_signatures.at(i) );
+        }
+        m_items = linear;
+        m_fields = fields;
+        m_signatures = signatures;
+        m_first = 0;
+        m_tail = 0;
+    }
+
+    QVector<Match> common;
+    if ( !commonItems(m_items, items, frame_max_edits, &common) ) {
+        /* keep at least common prefix and suffix */
+        const int n = m_items.size();
+        const int m = items.size();
+        int prefix = 0;
+        while ( prefix < n && prefix < m && m_items[prefix] == items[prefix] )
+            ++prefix;
+        int suffix = 0;
+        while ( suffix < n - prefix && suffix < m - prefix
+                && m_items[n - suffix - 1] == items[m - suffix - 1] )
+        {
+            ++suffix;
+        }
+
+        common.clear();
+        for (int i = 0; i < prefix; ++i)
+            common.append( Match(i, i) );
+        for (int i = suffix; i > 0; --i)
+            common.append( Match(n - i, m - i) );
+    }
+    common.append( Match(m_items.size(), items.size()) );
+
+    /* apply only removals and insertions between matching rows */
+    const int count = m_fieldNumbers.size();
+    int row = 0;
+    int a = 0;
+    int b = 0;
+    foreach (const Match &match, common) {
+        const int removed = match.first - a;
+        if (removed > 0) {
+            beginRemoveRows(QModelIndex(), row, row + removed - 1);
+            m_items.remove(row, removed);
+            m_fields.remove(row * count, removed * count);
+            m_signatures.remove(row, removed);
+            m_count -= removed;
+            endRemoveRows();
+        }
+
+        const int inserted = match.second - b;
+        if (inserted > 0) {
+            beginInsertRows(QModelIndex(), row, row + inserted - 1);
+            m_items.insert(row, inserted, Item());
+            m_fields.insert(row * count, inserted * count, FieldSpan());
+            m_signatures.insert(row, inserted, 0);
+            for (int i = 0; i < inserted; ++i)
+                setItem(row + i, items[b + i]);
+            m_count += inserted;
+            endInsertRows();
+        }
+
+        row += inserted + 1;
+        a = match.first + 1;
+        b = match.second + 1;
+    }
+}
+
 bool ItemModel::canFetchMore(const QModelIndex &) const
 {
-    return ( m_count != m_items.size() );
+    /* with frames, items are added only after whole frame is read */
+    return !m_frames && !m_pending.isEmpty();
 }
 
 void ItemModel::fetchMore(const QModelIndex &)
 {
-    int rows = m_items.size();
-    if (m_count == rows) return;
+    if ( !canFetchMore() ) return;
+
+    TRACE_SPAN("ItemModel::fetchMore");
+
+    if (m_tail > 0) {
+        /* don't keep more items than can be shown */
+        if ( m_pending.size() > m_tail )
+            m_pending.remove( 0, m_pending.size() - m_tail );
+
+        /* evict oldest rows in one batch */
+        const int overflow = qMin( m_count + m_pending.size() - m_tail, m_count );
+        if (overflow > 0)
+            removeOldest(overflow);
+    }
 
-    beginInsertRows(QModelIndex(), m_count, rows - 1);
-    m_count = rows;
+    const int rows = m_pending.size();
+    beginInsertRows(QModelIndex(), m_count, m_count + rows - 1);
+    foreach (const Item &item, m_pending) {
+        setItem( slot(m_count), item );
+        ++m_count;
+    }
+    m_pending.clear();
+
+    /* proxy filters and sorts new rows and view updates */
+    TRACE_SPAN("ItemModel::endInsertRows");
     endInsertRows();
 }
 
@@ -107,18 +571,52 @@ Qt::ItemFlags ItemModel::flags(const QModelIndex &index) const
     return QAbstractItemModel::flags(index);
 }
 
+void ItemModel::addLine(const char *data, int size)
+{
+    if ( m_frames && size > 0 && data[0] == '\f' ) {
+        /* form feed ends frame, rest of line is new item */
+        endFrame();
+        if (size > 1)
+            m_pending.append( Item(data + 1, size - 1) );
+    } else {
+        m_pending.append( Item(data, size) );
+    }
+}
+
+void ItemModel::addData(const char *data, int size)
+{
+    const char *end = data + size;
+
+    /* each line is one item */
+    while (data < end) {
+        const char *eol = static_cast<const char *>( memchr(data, '\n', end - data) );
+        if (!eol) {
+            m_line.append(data, end - data);
+            return;
+        }
+
+        if ( m_line.isEmpty() ) {
+            addLine(data, eol - data);
+        } else {
+            m_line.append(data, eol - data);
+            addLine( m_line.constData(), m_line.size() );
+            m_line.clear();
+        }
+
+        data = eol + 1;
+    }
+}
+
 void ItemModel::readStdin()
 {
-    static char buffer[BUFSIZ];
-    static QByteArray line;
+    TRACE_SPAN("ItemModel::readStdin");
+
+    static char buffer[stdin_chunk_size];
     static struct timeval stdin_tv = {0,0};
     fd_set stdin_fds;
 
-    /* disable stdin buffering (otherwise select waits on new line) */
-    setbuf(stdin, NULL);
-
     /*
-     * interrupt after reading at most N lines and
+     * interrupt after reading at most N chunks and
      * resume after processing pending events in event loop
      */
     for( int i = 0; i < stdin_batch_size; ++i ) {
@@ -131,29 +629,40 @@ void ItemModel::readStdin()
             break;
 
         /* read data */
-        if ( fgets(buffer, BUFSIZ, stdin) ) {
-            line.append(buffer);
-            /* each line is one item */
-            if ( line.endsWith('\n') ) {
-                line.resize( line.size()-1 );
-                m_items.append( QString::fromLocal8Bit(line.constData()) );
-                line.clear();
-            }
-        } else {
+        const ssize_t size = read( STDIN_FILENO, buffer, sizeof(buffer) );
+        if (size > 0) {
+            addData(buffer, size);
+        } else if (size == 0) {
+            m_stdinClosed = true;
+            break;
+        } else if (errno != EINTR && errno != EAGAIN) {
+            perror( tr("Error reading stdin!").toLocal8Bit().constData() );
+            m_stdinClosed = true;
             break;
         }
     }
 
-    if ( ferror(stdin) )
-        perror( tr("Error reading stdin!").toLocal8Bit().constData() );
-    else if ( !feof(stdin) )
+    if (m_stdinClosed) {
+        /* last line can end without new line */
+        if ( !m_line.isEmpty() ) {
+            addLine( m_line.constData(), m_line.size() );
+            m_line.clear();
+        }
+
+        /* last frame can end without form feed */
+        if ( m_frames && !m_pending.isEmpty() )
+            endFrame();
+    } else {
         m_timerFetch.start();
+    }
 }
 
 void ItemModel::updateItems()
 {
+    TRACE_SPAN("ItemModel::updateItems");
+
     if ( canFetchMore() )
         fetchMore();
-    if ( !ferror(stdin) && !feof(stdin) )
+    if (!m_stdinClosed)
         m_timerUpdate.start();
 }
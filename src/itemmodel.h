@@ -20,10 +20,13 @@
 #ifndef ITEMMODEL_H
 #define ITEMMODEL_H
 
+#include "item.h"
+
 #include <QAbstractListModel>
-#include <QStringList>
+#include <QDir>
 #include <QTimer>
 #include <QVariant>
+#include <QVector>
 
 class QSize;
 class QTimer;
@@ -32,6 +35,18 @@ class ItemModel : public QAbstractListModel
 {
     Q_OBJECT
 public:
+    enum {
+        /* text used for filtering */
+        FilterRole = Qt::UserRole
+    };
+
+    enum FieldUsage {
+        FilterField,
+        DisplayField,
+        OutputField,
+        FieldUsageCount
+    };
+
     explicit ItemModel(QObject *parent = NULL);
 
     int rowCount(const QModelIndex &parent = QModelIndex()) const;
@@ -43,14 +58,108 @@ public:
 
     void setItemSize(QSize &size);
 
-    const QStringList &items() const { return m_items; }
+    /* keep only newest items (0 for unlimited) */
+    void setTailSize(int size);
+
+    /* replace all items each time a line starting with form feed is read */
+    void setFrameMode(bool enable) { m_frames = enable; }
+
+    /*
+     * Fields are parts of item separated by delimiter (numbered from 1);
+     * field 0 is whole item. Fields are used for filtering, displaying
+     * and output.
+     */
+    void setDelimiter(char delimiter) { m_delimiter = delimiter; }
+    char delimiter() const { return m_delimiter; }
+    void setField(FieldUsage usage, int number);
+    int field(FieldUsage usage) const { return m_fieldNumber[usage]; }
+    bool hasFields() const { return !m_fieldNumbers.isEmpty(); }
+
+    /* don't read items from stdin */
+    void closeStdin();
+
+    /* remove all items */
+    void clear();
+
+    /* first row with given displayed text or -1 */
+    int indexOf(const QString &text) const;
+
+    /* displayed text */
+    QString itemText(int row) const { return fieldText(row, DisplayField); }
+
+    /* first character of displayed text (null if empty); whole text is not converted */
+    QChar firstChar(int row) const;
+
+    /* item text as read from input (or output field) */
+    QByteArray itemBytes(int row) const;
+
+    /*
+     * Append rows in range whose filter text has all characters of
+     * signature (see textSignature()); other rows can't contain the text.
+     */
+    void candidateRows(quint64 signature, int first, int last, QVector<int> *rows) const;
 
 private:
+    /* range of field in item bytes */
+    struct FieldSpan {
+        FieldSpan(quint32 start = 0, quint32 size = 0) : start(start), size(size) {}
+        quint32 start;
+        quint32 size;
+    };
+
+    int slot(int row) const;
+    void setItem(int slot, const Item &item);
+    void storeFields(int slot);
+    void storeSignature(int slot);
+    QString fieldText(int row, FieldUsage usage) const;
+    void removeOldest(int rows);
+    void endFrame();
+    void replaceItems(const QVector<Item> &items);
+    void addData(const char *data, int size);
+    void addLine(const char *data, int size);
+
+    /* number of rows in model */
     int m_count;
-    QStringList m_items;
+    /* items in ring buffer (if tail size is set) */
+    QVector<Item> m_items;
+    /* spans of used fields for each item (same order as m_items) */
+    QVector<FieldSpan> m_fields;
+    /* signatures of filter text (same order as m_items) */
+    QVector<quint64> m_signatures;
+    int m_first;
+    int m_tail;
+    bool m_frames;
+    /* items read but not yet in model */
+    QVector<Item> m_pending;
+    /* incomplete last line */
+    QByteArray m_line;
+    bool m_stdinClosed;
     QTimer m_timerFetch;
     QTimer m_timerUpdate;
     QVariant m_itemSize;
+    /* directory for relative file paths */
+    QDir m_baseDir;
+
+    char m_delimiter;
+    /* sorted field numbers (without duplicates) used for items */
+    QVector<int> m_fieldNumbers;
+    /* field numbers given by user */
+    int m_fieldNumber[FieldUsageCount];
+    /* index to m_fieldNumbers or -1 for whole item */
+    int m_fieldIndex[FieldUsageCount];
+
+public slots:
+    /* add new line separated items */
+    void addItems(const QByteArray &lines);
+
+    /* add items (data are not copied) */
+    void addItems(const QVector<Item> &items);
+
+    /* replace all items with new line separated items (only changed rows are updated) */
+    void setItems(const QByteArray &lines);
+
+    /* relative paths in items are resolved against directory (e.g. for icons) */
+    void setBaseDirectory(const QString &dir) { m_baseDir = QDir(dir); }
 
 private slots:
     void updateItems();
@@ -0,0 +1,62 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#include "linequeue.h"
+
+LineQueue::LineQueue(QObject *parent)
+    : QObject(parent)
+    , m_generation(0)
+{
+}
+
+void LineQueue::append(const QByteArray &lines, int generation)
+{
+    if ( lines.isEmpty() )
+        return;
+
+    QMutexLocker lock(&m_mutex);
+    if (generation != m_generation)
+        return;
+
+    /* emit lines from thread of this object (once for all lines appended meanwhile) */
+    const bool notify = m_lines.isEmpty();
+    m_lines.append(lines);
+    if (notify)
+        QMetaObject::invokeMethod(this, "flush", Qt::QueuedConnection);
+}
+
+void LineQueue::reset(int generation)
+{
+    QMutexLocker lock(&m_mutex);
+    m_lines.clear();
+    m_generation = generation;
+}
+
+void LineQueue::flush()
+{
+    QByteArray lines;
+    {
+        QMutexLocker lock(&m_mutex);
+        lines.swap(m_lines);
+    }
+
+    if ( !lines.isEmpty() )
+        emit linesAdded(lines);
+}
@@ -0,0 +1,57 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+
+#ifndef LINEQUEUE_H
+#define LINEQUEUE_H
+
+#include <QByteArray>
+#include <QMutex>
+#include <QObject>
+
+/*
+ * Collects lines appended from pool threads and emits them from thread of
+ * this object in batches (only once for all lines appended meanwhile).
+ */
+class LineQueue : public QObject
+{
+    Q_OBJECT
+public:
+    explicit LineQueue(QObject *parent = NULL);
+
+    /* thread-safe; lines of other than current generation are dropped */
+    void append(const QByteArray &lines, int generation = 0);
+
+    /* drop lines not yet emitted and set current generation */
+    void reset(int generation);
+
+signals:
+    /* new line separated items */
+    void linesAdded(const QByteArray &lines);
+
+private slots:
+    void flush();
+
+private:
+    QMutex m_mutex;
+    QByteArray m_lines;
+    int m_generation;
+};
+
+#endif // LINEQUEUE_H
@@ -0,0 +1,354 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "listview.h"
+
+#include "trace.h"
+
+#include <QAbstractItemDelegate>
+#include <QCursor>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+
+ListView::ListView(QWidget *parent)
+    : QListView(parent)
+{
+}
+
+void ListView::doItemsLayout()
+{
+    TRACE_SPAN("ListView::doItemsLayout");
+
+    /* skip QListView layout, positions are computed when needed */
+    if (isGridLayout())
+        QAbstractItemView::doItemsLayout();
+    else
+        QListView::doItemsLayout();
+}
+
+QRect ListView::visualRect(const QModelIndex &index) const
+{
+    if (!isGridLayout())
+        return QListView::visualRect(index);
+
+    if (!index.isValid() || index.parent() != rootIndex() || index.column() != modelColumn())
+        return QRect();
+
+    const QSize grid = gridSize();
+    const int rows = columnRows();
+    const int row = index.row();
+
+    return QRect( (row / rows) * grid.width() - horizontalOffset(),
+                  (row % rows) * grid.height() - verticalOffset(),
+                  grid.width(), grid.height() );
+}
+
+QModelIndex ListView::indexAt(const QPoint &point) const
+{
+    if (!isGridLayout())
+        return QListView::indexAt(point);
+
+    const QSize grid = gridSize();
+    const int x = point.x() + horizontalOffset();
+    const int y = point.y() + verticalOffset();
+    if (x < 0 || y < 0)
+        return QModelIndex();
+
+    const int rows = columnRows();
+    const int rowInColumn = y / grid.height();
+    if (rowInColumn >= rows)
+        return QModelIndex();
+
+    const int row = (x / grid.width()) * rows + rowInColumn;
+    if (row >= rowCount())
+        return QModelIndex();
+
+    return model()->index(row, modelColumn(), rootIndex());
+}
+
+void ListView::scrollTo(const QModelIndex &index, ScrollHint hint)
+{
+    if (!isGridLayout()) {
+        QListView::scrollTo(index, hint);
+        return;
+    }
+
+    const QRect rect = visualRect(index);
+    if (!rect.isValid())
+        return;
+
+    const QRect area = viewport()->rect();
+    QScrollBar *scrollBar = horizontalScrollBar();
+    int value = scrollBar->value();
+
+    switch (hint) {
+    case PositionAtTop:
+        value += rect.left();
+        break;
+    case PositionAtBottom:
+        value += rect.right() - area.right();
+        break;
+    case PositionAtCenter:
+        value += rect.center().x() - area.center().x();
+        break;
+    default:
+        if (rect.left() < area.left())
+            value += rect.left();
+        else if (rect.right() > area.right())
+            value += qMin(rect.left(), rect.right() - area.right());
+        break;
+    }
+
+    scrollBar->setValue(value);
+}
+
+void ListView::updateGeometries()
+{
+    TRACE_SPAN("ListView::updateGeometries");
+
+    if (!isGridLayout()) {
+        QListView::updateGeometries();
+        return;
+    }
+
+    const int rows = columnRows();
+    const int columns = (rowCount() + rows - 1) / rows;
+    const int width = gridSize().width();
+    const int viewportWidth = viewport()->width();
+
+    QScrollBar *scrollBar = horizontalScrollBar();
+    scrollBar->setSingleStep(width);
+    scrollBar->setPageStep(viewportWidth);
+    scrollBar->setRange(0, qMax(0, columns * width - viewportWidth));
+
+    verticalScrollBar()->setRange(0, 0);
+
+    QAbstractItemView::updateGeometries();
+}
+
+void ListView::paintEvent(QPaintEvent *event)
+{
+    TRACE_SPAN("ListView::paintEvent");
+
+    if (!isGridLayout()) {
+        QListView::paintEvent(event);
+        return;
+    }
+
+    int first;
+    int last;
+    rowsInRect(event->rect(), &first, &last);
+    if (first > last)
+        return;
+
+    QStyleOptionViewItem option = viewOptions();
+    option.state &= ~QStyle::State_HasFocus;
+    const QStyle::State state = option.state;
+    const bool enabled = state & QStyle::State_Enabled;
+
+    const QModelIndex current = currentIndex();
+    const bool focus = (hasFocus() || viewport()->hasFocus()) && current.isValid();
+
+    const QPoint cursor = viewport()->mapFromGlobal(QCursor::pos());
+    const QModelIndex hover = viewport()->underMouse() ? indexAt(cursor) : QModelIndex();
+
+    const QItemSelectionModel *selection = selectionModel();
+
+    QPainter painter(viewport());
+
+    for (int row = first; row <= last; ++row) {
+        const QModelIndex index = model()->index(row, modelColumn(), rootIndex());
+
+        option.rect = visualRect(index);
+        option.state = state;
+
+        if (selection && selection->isSelected(index))
+            option.state |= QStyle::State_Selected;
+
+        if (enabled) {
+            if (model()->flags(index) & Qt::ItemIsEnabled) {
+                option.palette.setCurrentColorGroup(QPalette::Normal);
+            } else {
+                option.state &= ~QStyle::State_Enabled;
+                option.palette.setCurrentColorGroup(QPalette::Disabled);
+            }
+        }
+
+        if (focus && index == current)
+            option.state |= QStyle::State_HasFocus;
+
+        if (index == hover)
+            option.state |= QStyle::State_MouseOver;
+
+        itemDelegate(index)->paint(&painter, option, index);
+    }
+}
+
+void ListView::scrollContentsBy(int dx, int dy)
+{
+    if (isGridLayout())
+        QAbstractItemView::scrollContentsBy(dx, dy);
+    else
+        QListView::scrollContentsBy(dx, dy);
+}
+
+QModelIndex ListView::moveCursor(CursorAction cursorAction, Qt::KeyboardModifiers modifiers)
+{
+    if (!isGridLayout())
+        return QListView::moveCursor(cursorAction, modifiers);
+
+    const int count = rowCount();
+    if (count == 0)
+        return QModelIndex();
+
+    const QModelIndex current = currentIndex();
+    if (!current.isValid())
+        return model()->index(0, modelColumn(), rootIndex());
+
+    const int rows = columnRows();
+    const int pageColumns = qMax(1, viewport()->width() / gridSize().width());
+    int row = current.row();
+
+    switch (cursorAction) {
+    case MoveUp:
+    case MovePrevious:
+        --row;
+        break;
+    case MoveDown:
+    case MoveNext:
+        ++row;
+        break;
+    case MoveLeft:
+        row -= rows;
+        break;
+    case MoveRight:
+        row += rows;
+        break;
+    case MovePageUp:
+        row -= rows * pageColumns;
+        break;
+    case MovePageDown:
+        row += rows * pageColumns;
+        break;
+    case MoveHome:
+        row = 0;
+        break;
+    case MoveEnd:
+        row = count - 1;
+        break;
+    }
+
+    return model()->index(qBound(0, row, count - 1), modelColumn(), rootIndex());
+}
+
+int ListView::horizontalOffset() const
+{
+    return isGridLayout() ? horizontalScrollBar()->value() : QListView::horizontalOffset();
+}
+
+int ListView::verticalOffset() const
+{
+    return isGridLayout() ? verticalScrollBar()->value() : QListView::verticalOffset();
+}
+
+void ListView::setSelection(const QRect &rect, QItemSelectionModel::SelectionFlags command)
+{
+    if (!isGridLayout()) {
+        QListView::setSelection(rect, command);
+        return;
+    }
+
+    const QSize grid = gridSize();
+    const int rows = columnRows();
+    const int count = rowCount();
+
+    const QRect area = rect.normalized().translated(horizontalOffset(), verticalOffset());
+    const int firstColumn = qMax(0, area.left()) / grid.width();
+    const int lastColumn = qMax(0, area.right()) / grid.width();
+    const int firstRow = qMax(0, area.top()) / grid.height();
+    const int lastRow = qMin(rows - 1, qMax(0, area.bottom()) / grid.height());
+
+    /* each column is continuous range of rows */
+    QItemSelection selection;
+    for (int column = firstColumn; column <= lastColumn && firstRow <= lastRow; ++column) {
+        const int first = column * rows + firstRow;
+        const int last = qMin(count - 1, column * rows + lastRow);
+        if (first > last)
+            break;
+        selection.select( model()->index(first, modelColumn(), rootIndex()),
+                          model()->index(last, modelColumn(), rootIndex()) );
+    }
+
+    selectionModel()->select(selection, command);
+}
+
+QRegion ListView::visualRegionForSelection(const QItemSelection &selection) const
+{
+    if (!isGridLayout())
+        return QListView::visualRegionForSelection(selection);
+
+    int first;
+    int last;
+    rowsInRect(viewport()->rect(), &first, &last);
+
+    /* only visible part of selection is needed (all items can be selected) */
+    QRegion region;
+    foreach ( const QItemSelectionRange &range, selection ) {
+        if (!range.isValid() || range.parent() != rootIndex())
+            continue;
+
+        const int top = qMax(range.top(), first);
+        const int bottom = qMin(range.bottom(), last);
+        for (int row = top; row <= bottom; ++row)
+            region += visualRect( model()->index(row, modelColumn(), rootIndex()) );
+    }
+
+    return region;
+}
+
+bool ListView::isGridLayout() const
+{
+    const QSize grid = gridSize();
+    return model() != NULL && isWrapping() && viewMode() == ListMode && flow() == TopToBottom
+            && grid.width() > 0 && grid.height() > 0;
+}
+
+int ListView::rowCount() const
+{
+    return model()->rowCount(rootIndex());
+}
+
+int ListView::columnRows() const
+{
+    return qMax(1, viewport()->height() / gridSize().height());
+}
+
+void ListView::rowsInRect(const QRect &rect, int *first, int *last) const
+{
+    const QSize grid = gridSize();
+    const int rows = columnRows();
+
+    const QRect area = rect.translated(horizontalOffset(), verticalOffset());
+    const int firstColumn = qMax(0, area.left()) / grid.width();
+    const int lastColumn = qMax(0, area.right()) / grid.width();
+
+    *first = firstColumn * rows;
+    *last = qMin(rowCount() - 1, (lastColumn + 1) * rows - 1);
+}
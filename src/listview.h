@@ -0,0 +1,64 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef LISTVIEW_H
+#define LISTVIEW_H
+
+#include <QListView>
+
+class ListView : public QListView
+{
+    Q_OBJECT
+public:
+    explicit ListView(QWidget *parent = NULL);
+
+    void doItemsLayout();
+
+    QRect visualRect(const QModelIndex &index) const;
+    QModelIndex indexAt(const QPoint &point) const;
+    void scrollTo(const QModelIndex &index, ScrollHint hint = EnsureVisible);
+
+protected:
+    void updateGeometries();
+    void paintEvent(QPaintEvent *event);
+    void scrollContentsBy(int dx, int dy);
+
+    QModelIndex moveCursor(CursorAction cursorAction, Qt::KeyboardModifiers modifiers);
+    int horizontalOffset() const;
+    int verticalOffset() const;
+    void setSelection(const QRect &rect, QItemSelectionModel::SelectionFlags command);
+    QRegion visualRegionForSelection(const QItemSelection &selection) const;
+
+private:
+    /*
+     * Items wrapped in columns of fixed grid size are positioned arithmetically
+     * instead of letting QListView compute and store position of each item.
+     */
+    bool isGridLayout() const;
+
+    int rowCount() const;
+
+    /* number of items in single column */
+    int columnRows() const;
+
+    /* first and last row intersecting rectangle in viewport coordinates */
+    void rowsInRect(const QRect &rect, int *first, int *last) const;
+};
+
+#endif // LISTVIEW_H
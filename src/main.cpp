@@ -18,6 +18,9 @@
 */
 
 #include "dialog.h"
+#include "replay.h"
+#include "trace.h"
+#include "watchdog.h"
 
 #include <QApplication>
 #include <QDesktopWidget>
@@ -26,6 +29,7 @@
 
 #include <cerrno>
 #include <cstdio>
+#include <cstring>
 #include <unistd.h>
 
 struct Argument {
@@ -34,33 +38,63 @@ struct Argument {
 };
 
 const Argument arguments[] = {
+    {'a', "accept-nth"},
     {'c', "command"},
+    {'d', "delimiter"},
+    {'D', "walk"},
+    {'e', "source"},
+    {'F', "frames"},
     {'g', "geometry"},
     {'h', "help"},
+    {'H', "hidden"},
+    {'i', "input"},
+    {'k', "tag-sources"},
     {'l', "label"},
+    {'L', "depth"},
     {'m', "minimal"},
+    {'M', "shared-memory"},
+    {'n', "nth"},
+    {'N', "with-nth"},
     {'o', "sort"},
     {'p', "opacity"},
+    {'r', "regex"},
     {'s', "style"},
     {'S', "strict"},
     {'t', "title"},
+    {'T', "tail"},
     {'w', "wrap"},
+    {'x', "path-executables"},
     {'z', "size"},
 };
 
 static QString helpString(const char shopt)
 {
+    if (shopt == 'a') return QObject::tr("print only given field of item (numbered from 1)");
     if (shopt == 'c') return QObject::tr("exec command on items");
+    if (shopt == 'd') return QObject::tr("field delimiter (default is tab)");
+    if (shopt == 'D') return QObject::tr("list files in directory instead of reading stdin");
+    if (shopt == 'e') return QObject::tr("read items from output of shell command (can be repeated)");
+    if (shopt == 'F') return QObject::tr("replace items after each line starting with form feed");
     if (shopt == 'g') return QObject::tr("window size and position (format: width,height,x,y)");
     if (shopt == 'h') return QObject::tr("show this help");
+    if (shopt == 'H') return QObject::tr("list hidden files");
+    if (shopt == 'i') return QObject::tr("read items from file, \"-\" for stdin (can be repeated)");
+    if (shopt == 'k') return QObject::tr("prefix items with source and delimiter (first field)");
     if (shopt == 'l') return QObject::tr("text input label");
+    if (shopt == 'L') return QObject::tr("directory depth to list (default is 1, 0 for unlimited)");
     if (shopt == 'm') return QObject::tr("show popup menu instead of list");
+    if (shopt == 'M') return QObject::tr("read items from shared memory (format: memfd,eventfd)");
+    if (shopt == 'n') return QObject::tr("filter items only by given field");
+    if (shopt == 'N') return QObject::tr("show only given field of items");
     if (shopt == 'o') return QObject::tr("sort items alphabetically");
     if (shopt == 'p') return QObject::tr("window opacity (value from 0.0 to 1.0)");
+    if (shopt == 'r') return QObject::tr("filter items using regular expressions");
     if (shopt == 's') return QObject::tr("stylesheet");
     if (shopt == 'S') return QObject::tr("choose only items from stdin");
     if (shopt == 't') return QObject::tr("title");
+    if (shopt == 'T') return QObject::tr("keep only last N items");
     if (shopt == 'w') return QObject::tr("wrap items");
+    if (shopt == 'x') return QObject::tr("list executables in PATH instead of reading stdin");
     if (shopt == 'z') return QObject::tr("item size (format: width,height)");
     return "";
 }
@@ -70,6 +104,11 @@ static void printLine(const QString &msg)
     printf( "%s", (msg + "\n").toLocal8Bit().constData() );
 }
 
+static void printError(const QString &msg)
+{
+    fprintf( stderr, "%s", (msg + "\n").toLocal8Bit().constData() );
+}
+
 /* print help and exit */
 static void help(int exit_code)
 {
@@ -79,7 +118,11 @@ static void help(int exit_code)
     printLine( QObject::tr("options:") );
     for ( int i = 0; i<len; ++i ) {
         const Argument &arg = arguments[i];
-        printf( "  -%c, --%-12s ", arg.shopt, arg.opt );
+        /* same layout as in README (long options on separate line) */
+        if ( strlen(arg.opt) > 11 )
+            printf( "  -%c, --%s\n%20s", arg.shopt, arg.opt, "" );
+        else
+            printf( "  -%c, --%-11s ", arg.shopt, arg.opt );
         printLine(helpString(arg.shopt));
     }
     exit(exit_code);
@@ -148,6 +191,8 @@ static void parseArguments(int argc, char *argv[], Dialog &dialog,
     bool ok;
     char c;
     bool force_arg;
+    bool frames = false;
+    bool tail = false;
     int len = sizeof(arguments)/sizeof(Argument);
 
     int i = 1;
@@ -191,11 +236,47 @@ static void parseArguments(int argc, char *argv[], Dialog &dialog,
 
         /* do action */
         const char arg = arguments[j].shopt;
-        if (arg == 'c') {
+        if (arg == 'a' || arg == 'n' || arg == 'N') {
+            if (!argp) help(1);
+            ++i;
+
+            if ( sscanf(argp, "%d%c", &num, &c) != 1 || num <= 0 )
+                help(1);
+
+            if (arg == 'a')
+                dialog.setOutputField(num);
+            else if (arg == 'n')
+                dialog.setFilterField(num);
+            else
+                dialog.setDisplayField(num);
+        } else if (arg == 'c') {
             if (!argp) help(1);
             ++i;
             parseCommand(argp, command_args);
             dialog.saveOutput(&command_args);
+        } else if (arg == 'd') {
+            if (!argp) help(1);
+            ++i;
+
+            /* single ASCII character or "\t" */
+            if ( strcmp(argp, "\\t") == 0 )
+                dialog.setDelimiter('\t');
+            else if ( argp[0] != '\0' && argp[1] == '\0' && static_cast<unsigned char>(argp[0]) < 0x80 )
+                dialog.setDelimiter(argp[0]);
+            else
+                help(1);
+        } else if (arg == 'D') {
+            if (!argp) help(1);
+            ++i;
+            dialog.walk( QFile::decodeName(argp) );
+        } else if (arg == 'e') {
+            if (!argp) help(1);
+            ++i;
+            dialog.readSource( QString::fromLocal8Bit(argp) );
+        } else if (arg == 'F') {
+            if (force_arg) help(1);
+            dialog.setFrameMode(true);
+            frames = true;
         } else if (arg == 'g') {
             if (!argp) help(1);
             ++i;
@@ -257,13 +338,40 @@ static void parseArguments(int argc, char *argv[], Dialog &dialog,
         } else if (arg == 'h') {
             if (force_arg) help(1);
             help(0);
+        } else if (arg == 'H') {
+            if (force_arg) help(1);
+            dialog.setShowHidden(true);
+        } else if (arg == 'i') {
+            if (!argp) help(1);
+            ++i;
+            dialog.readInput( QFile::decodeName(argp) );
+        } else if (arg == 'k') {
+            if (force_arg) help(1);
+            dialog.setTagSources(true);
         } else if (arg == 'l') {
             if (!argp) help(1);
             ++i;
             dialog.setLabel(argp);
+        } else if (arg == 'L') {
+            if (!argp) help(1);
+            ++i;
+
+            if ( sscanf(argp, "%d%c", &num, &c) != 1 || num < 0 )
+                help(1);
+
+            dialog.setWalkDepth(num);
         } else if (arg == 'm') {
             if (force_arg) help(1);
             dialog.hideList(true);
+        } else if (arg == 'M') {
+            if (!argp) help(1);
+            ++i;
+
+            int fd;
+            if ( sscanf(argp, "%d,%d%c", &num, &fd, &c) != 2 || num < 0 || fd < 0 )
+                help(1);
+            if ( !dialog.readSharedMemory(num, fd) )
+                exit(1);
         } else if (arg == 'o') {
             if (force_arg) help(1);
             dialog.sortList();
@@ -274,6 +382,9 @@ static void parseArguments(int argc, char *argv[], Dialog &dialog,
             if (num != 1 || fnum < 0.0f || fnum > 1.0f)
                 help(1);
             dialog.setWindowOpacity(fnum);
+        } else if (arg == 'r') {
+            if (force_arg) help(1);
+            dialog.setRegexMode(true);
         } else if (arg == 's') {
             if (!argp) help(1);
             ++i;
@@ -291,9 +402,21 @@ static void parseArguments(int argc, char *argv[], Dialog &dialog,
             if (!argp) help(1);
             ++i;
             dialog.setWindowTitle(argp);
+        } else if (arg == 'T') {
+            if (!argp) help(1);
+            ++i;
+
+            if ( sscanf(argp, "%d%c", &num, &c) != 1 || num <= 0 )
+                help(1);
+
+            dialog.setTailSize(num);
+            tail = true;
         } else if (arg == 'w') {
             if (force_arg) help(1);
             dialog.setWrapping(true);
+        } else if (arg == 'x') {
+            if (force_arg) help(1);
+            dialog.listPathExecutables();
         } else if (arg == 'z') {
             if (!argp) help(1);
             ++i;
@@ -308,6 +431,12 @@ static void parseArguments(int argc, char *argv[], Dialog &dialog,
             help(1);
         }
     }
+
+    /* each frame replaces all items so there is no tail to keep */
+    if (frames && tail) {
+        printError( QObject::tr("options --frames and --tail cannot be used together") );
+        exit(1);
+    }
 }
 
 int main(int argc, char *argv[])
@@ -318,16 +447,30 @@ int main(int argc, char *argv[])
     QApplication app(argc, argv);
     app.setQuitOnLastWindowClosed(false);
 
+    traceInit();
+    Watchdog *watchdog = Watchdog::fromEnvironment(&app);
+
     Dialog dialog;
 
     parseArguments(argc, argv, dialog, command_args);
 
     dialog.show();
 
+    Replay *replay = Replay::fromEnvironment(&dialog);
+
     exit_code = app.exec();
 
+    traceWrite();
+    if (watchdog)
+        watchdog->report( QString::fromLocal8Bit(qgetenv("SPRINTER_WATCHDOG_LOG")) );
+    if (replay)
+        replay->report( QString::fromLocal8Bit(qgetenv("SPRINTER_REPLAY_LOG")) );
+
     /* exec command */
     if ( !exit_code && !command_args.isEmpty() ) {
+        /* dialog is not destroyed before exec so sources must be stopped here */
+        dialog.stopSources();
+
         int len = command_args.size();
         char **new_argv = new char* [len+1];
 
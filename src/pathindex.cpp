@@ -0,0 +1,215 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "pathindex.h"
+
+#include "trace.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QSet>
+#include <QStandardPaths>
+#include <QStringList>
+
+#include <cstring>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const quint32 path_index_version = 1;
+
+/* modification time in nanoseconds or -1 if directory doesn't exist */
+static qint64 modificationTime(const QByteArray &dir)
+{
+    struct stat info;
+    if ( stat(dir.constData(), &info) != 0 || !S_ISDIR(info.st_mode) )
+        return -1;
+    return static_cast<qint64>(info.st_mtim.tv_sec) * 1000000000 + info.st_mtim.tv_nsec;
+}
+
+PathIndex::PathIndex(QObject *parent)
+    : QObject(parent)
+{
+    /* revalidate once after many changes (e.g. when installing packages) */
+    m_timerRevalidate.setSingleShot(true);
+    m_timerRevalidate.setInterval(250);
+    connect( &m_timerRevalidate, SIGNAL(timeout()),
+             this, SLOT(revalidate()) );
+    connect( &m_watcher, SIGNAL(directoryChanged(QString)),
+             &m_timerRevalidate, SLOT(start()) );
+
+    const QString cacheDir =
+            QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+    if ( !cacheDir.isEmpty() )
+        m_cacheFile = cacheDir + "/path-index";
+}
+
+void PathIndex::start()
+{
+    m_path.clear();
+    foreach ( const QByteArray &dir, qgetenv("PATH").split(':') ) {
+        if ( !dir.isEmpty() && !m_path.contains(dir) )
+            m_path.append(dir);
+    }
+
+    /* show cached items at once and check directories later */
+    load();
+    if ( !m_dirs.isEmpty() )
+        emitItems();
+    QTimer::singleShot( 0, this, SLOT(revalidate()) );
+}
+
+void PathIndex::revalidate()
+{
+    TRACE_SPAN("PathIndex::revalidate");
+
+    bool changed = m_dirs.isEmpty();
+    const QStringList watching = m_watcher.directories();
+    QStringList watched;
+
+    foreach (const QByteArray &dir, m_path) {
+        if ( update(dir) )
+            changed = true;
+
+        const QString path = QFile::decodeName(dir);
+        if ( m_dirs.value(dir).mtime != -1 && !watching.contains(path) )
+            watched.append(path);
+    }
+
+    /* forget directories removed from PATH */
+    foreach ( const QByteArray &dir, m_dirs.keys() ) {
+        if ( !m_path.contains(dir) ) {
+            m_dirs.remove(dir);
+            changed = true;
+        }
+    }
+
+    if ( !watched.isEmpty() )
+        m_watcher.addPaths(watched);
+
+    if (changed) {
+        emitItems();
+        save();
+    }
+}
+
+bool PathIndex::update(const QByteArray &dir)
+{
+    const qint64 mtime = modificationTime(dir);
+    Directory &directory = m_dirs[dir];
+    if (mtime == directory.mtime)
+        return false;
+
+    TRACE_SPAN("PathIndex::update");
+
+    directory.mtime = mtime;
+    directory.names.clear();
+
+    DIR *d = mtime == -1 ? NULL : opendir( dir.constData() );
+    if (!d)
+        return true;
+
+    struct dirent *entry;
+    while ( (entry = readdir(d)) != NULL ) {
+        const char *name = entry->d_name;
+        if ( name[0] == '.' && (name[1] == '\0' || (name[1] == '.' && name[2] == '\0')) )
+            continue;
+        if (entry->d_type == DT_DIR)
+            continue;
+
+        /* executable files (not directories) */
+        if ( faccessat(dirfd(d), name, X_OK, 0) != 0 )
+            continue;
+        if (entry->d_type != DT_REG) {
+            struct stat info;
+            if ( fstatat(dirfd(d), name, &info, 0) != 0 || S_ISDIR(info.st_mode) )
+                continue;
+        }
+
+        directory.names.append(name);
+    }
+    closedir(d);
+
+    return true;
+}
+
+void PathIndex::emitItems()
+{
+    QByteArray lines;
+    QSet<QByteArray> seen;
+
+    /* executables in directories earlier in PATH hide later ones */
+    foreach (const QByteArray &dir, m_path) {
+        foreach ( const QByteArray &name, m_dirs.value(dir).names ) {
+            if ( seen.contains(name) || strchr(name.constData(), '\n') )
+                continue;
+            seen.insert(name);
+            lines.append(name).append('\n');
+        }
+    }
+
+    emit itemsChanged(lines);
+}
+
+void PathIndex::load()
+{
+    QFile file(m_cacheFile);
+    if ( m_cacheFile.isEmpty() || !file.open(QIODevice::ReadOnly) )
+        return;
+
+    QDataStream stream(&file);
+    quint32 version;
+    stream >> version;
+    if (version != path_index_version)
+        return;
+
+    while ( !stream.atEnd() && stream.status() == QDataStream::Ok ) {
+        QByteArray dir;
+        Directory directory;
+        stream >> dir >> directory.mtime >> directory.names;
+        if ( stream.status() == QDataStream::Ok )
+            m_dirs.insert(dir, directory);
+    }
+}
+
+void PathIndex::save()
+{
+    if ( m_cacheFile.isEmpty() )
+        return;
+
+    QDir().mkpath( QFileInfo(m_cacheFile).absolutePath() );
+
+    QSaveFile file(m_cacheFile);
+    if ( !file.open(QIODevice::WriteOnly) )
+        return;
+
+    QDataStream stream(&file);
+    stream << path_index_version;
+    for ( QHash<QByteArray, Directory>::const_iterator it = m_dirs.constBegin();
+          it != m_dirs.constEnd(); ++it )
+    {
+        stream << it.key() << it.value().mtime << it.value().names;
+    }
+
+    file.commit();
+}
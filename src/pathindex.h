@@ -0,0 +1,72 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef PATHINDEX_H
+#define PATHINDEX_H
+
+#include <QByteArray>
+#include <QFileSystemWatcher>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QTimer>
+
+/*
+ * Lists executables in directories from PATH environment variable.
+ *
+ * Names are cached in a file with modification time of each directory
+ * so only changed directories are listed again. While running,
+ * directories are watched for changes (using inotify on Linux).
+ */
+class PathIndex : public QObject
+{
+    Q_OBJECT
+public:
+    explicit PathIndex(QObject *parent = NULL);
+
+public slots:
+    void start();
+
+signals:
+    /* all items (new line separated) each time they change */
+    void itemsChanged(const QByteArray &lines);
+
+private slots:
+    void revalidate();
+
+private:
+    struct Directory {
+        Directory() : mtime(-1) {}
+        qint64 mtime;
+        QList<QByteArray> names;
+    };
+
+    bool update(const QByteArray &dir);
+    void emitItems();
+    void load();
+    void save();
+
+    QList<QByteArray> m_path;
+    QHash<QByteArray, Directory> m_dirs;
+    QFileSystemWatcher m_watcher;
+    QTimer m_timerRevalidate;
+    QString m_cacheFile;
+};
+
+#endif // PATHINDEX_H
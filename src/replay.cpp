@@ -0,0 +1,269 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "replay.h"
+
+#include "trace.h"
+
+#include <QApplication>
+#include <QFile>
+#include <QKeyEvent>
+#include <QKeySequence>
+#include <QLineEdit>
+#include <QRegExp>
+#include <QTextStream>
+#include <QWidget>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+
+/* wait for frames answering last keys at most this long (milliseconds) */
+static const int replay_finish_timeout = 5000;
+
+Replay *Replay::fromEnvironment(QWidget *dialog)
+{
+    const QString fileName = QString::fromLocal8Bit( qgetenv("SPRINTER_REPLAY") );
+    if ( fileName.isEmpty() )
+        return NULL;
+
+    Replay *replay = new Replay(dialog, dialog);
+    if ( !replay->load(fileName) )
+        exit(1);
+
+    /* start after dialog is shown */
+    QMetaObject::invokeMethod(replay, "start", Qt::QueuedConnection);
+    return replay;
+}
+
+Replay::Replay(QWidget *dialog, QObject *parent)
+    : QObject(parent)
+    , m_dialog(dialog)
+    , m_edit( dialog->findChild<QLineEdit *>() )
+    , m_next(0)
+    , m_pending(0)
+    , m_generation(0)
+    , m_requested(0)
+    , m_filtered(0)
+{
+    m_timerKey.setSingleShot(true);
+    m_timerKey.setTimerType(Qt::PreciseTimer);
+    connect( &m_timerKey, SIGNAL(timeout()), this, SLOT(sendNextKey()) );
+
+    m_timerFinish.setSingleShot(true);
+    m_timerFinish.setInterval(replay_finish_timeout);
+    connect( &m_timerFinish, SIGNAL(timeout()), this, SLOT(finish()) );
+
+    if (m_edit)
+        connect( m_edit, SIGNAL(textEdited(QString)), this, SLOT(textEdited()) );
+    connect( dialog, SIGNAL(filterStarted()), this, SLOT(filterStarted()) );
+    connect( dialog, SIGNAL(filterUpdated()), this, SLOT(filterUpdated()) );
+
+    dialog->installEventFilter(this);
+}
+
+bool Replay::load(const QString &fileName)
+{
+    QFile file(fileName);
+    if ( !file.open(QIODevice::ReadOnly) ) {
+        fprintf( stderr, "%s\n", tr("Cannot open replay script \"%1\"!")
+                 .arg(fileName).toLocal8Bit().constData() );
+        return false;
+    }
+
+    QTextStream in(&file);
+    int lineNumber = 0;
+    while ( !in.atEnd() ) {
+        const QString line = in.readLine().trimmed();
+        ++lineNumber;
+        if ( line.isEmpty() || line.startsWith('#') )
+            continue;
+
+        const int separator = line.indexOf( QRegExp("\\s") );
+        bool ok = false;
+        const qint64 time = separator == -1 ? -1 : line.left(separator).toLongLong(&ok) * 1000;
+
+        Key key;
+        if ( !ok || time < 0 || !parseKey(line.mid(separator).trimmed(), &key) ) {
+            fprintf( stderr, "%s\n", tr("Invalid key on line %1 of replay script \"%2\"!")
+                     .arg(lineNumber).arg(fileName).toLocal8Bit().constData() );
+            return false;
+        }
+
+        key.time = time;
+        key.generation = 0;
+        key.latency = -1;
+        m_keys.append(key);
+    }
+
+    return true;
+}
+
+void Replay::report(const QString &fileName)
+{
+    QFile file(fileName);
+    if ( fileName.isEmpty() || !file.open(QIODevice::WriteOnly) )
+        file.open(stderr, QIODevice::WriteOnly);
+
+    QTextStream out(&file);
+
+    QVector<qint64> latencies;
+    foreach (const Key &key, m_keys) {
+        if (key.latency >= 0)
+            latencies.append(key.latency);
+    }
+    std::sort( latencies.begin(), latencies.end() );
+
+    out << tr("Replayed keys: %1 of %2, without frame: %3")
+           .arg(m_next).arg(m_keys.size()).arg(m_next - latencies.size()) << "\n";
+    if ( latencies.isEmpty() )
+        return;
+
+    qint64 total = 0;
+    foreach (qint64 latency, latencies)
+        total += latency;
+
+    const int percentiles[] = {50, 90, 95, 99, 100};
+    out << tr("Key to frame latency (ms):") << "\n";
+    out << "  " << QString("mean").leftJustified(8)
+        << QString::number(total / 1000.0 / latencies.size(), 'f', 2) << "\n";
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+        const int p = percentiles[i];
+        /* nearest rank */
+        const int rank = qMax(1, (p * latencies.size() + 99) / 100);
+        const QString name = p == 100 ? QString("max") : QString("p%1").arg(p);
+        out << "  " << name.leftJustified(8)
+            << QString::number(latencies[rank - 1] / 1000.0, 'f', 2) << "\n";
+    }
+}
+
+bool Replay::eventFilter(QObject *obj, QEvent *event)
+{
+    if ( obj != m_dialog || event->type() != QEvent::UpdateRequest )
+        return false;
+
+    /* paint the window first to get time when frame is finished */
+    obj->event(event);
+    frame();
+    return true;
+}
+
+void Replay::start()
+{
+    m_dialog->activateWindow();
+    m_clock.start();
+    sendNextKey();
+}
+
+void Replay::sendNextKey()
+{
+    const qint64 now = m_clock.nsecsElapsed() / 1000;
+
+    /* send all keys that are due (event loop could be blocked) */
+    while ( m_next < m_keys.size() && m_keys[m_next].time <= now ) {
+        Key &key = m_keys[m_next];
+        ++m_next;
+
+        QWidget *target = QApplication::focusWidget();
+        if (!target)
+            target = m_dialog;
+
+        TRACE_SPAN("Replay::sendKey");
+        QKeyEvent press(QEvent::KeyPress, key.key, key.modifiers, key.text);
+        QApplication::sendEvent(target, &press);
+        QKeyEvent release(QEvent::KeyRelease, key.key, key.modifiers, key.text);
+        QApplication::sendEvent(target, &release);
+
+        key.generation = m_generation;
+
+        /* the key could have closed the dialog */
+        if ( !m_dialog->isVisible() )
+            return;
+    }
+
+    if ( m_next < m_keys.size() ) {
+        const qint64 wait = m_keys[m_next].time - m_clock.nsecsElapsed() / 1000;
+        m_timerKey.start( static_cast<int>(qMax<qint64>(0, (wait + 999) / 1000)) );
+    } else if (m_pending == m_next) {
+        finish();
+    } else {
+        m_timerFinish.start();
+    }
+}
+
+void Replay::textEdited()
+{
+    ++m_generation;
+}
+
+void Replay::filterStarted()
+{
+    m_requested = m_generation;
+}
+
+void Replay::filterUpdated()
+{
+    m_filtered = m_requested;
+}
+
+void Replay::finish()
+{
+    m_timerKey.stop();
+    m_timerFinish.stop();
+    qApp->exit(0);
+}
+
+bool Replay::parseKey(const QString &name, Replay::Key *key)
+{
+    key->modifiers = Qt::NoModifier;
+
+    /* single character is typed text */
+    if (name.size() == 1) {
+        key->key = name[0].toUpper().unicode();
+        key->text = name;
+        return true;
+    }
+
+    const QKeySequence sequence = QKeySequence::fromString(name, QKeySequence::PortableText);
+    if ( sequence.count() != 1 || sequence[0] == Qt::Key_unknown )
+        return false;
+
+    key->key = sequence[0] & ~Qt::KeyboardModifierMask;
+    key->modifiers = Qt::KeyboardModifiers(sequence[0] & Qt::KeyboardModifierMask);
+    if (key->key == Qt::Key_Space && key->modifiers == Qt::NoModifier)
+        key->text = " ";
+
+    return true;
+}
+
+void Replay::frame()
+{
+    const qint64 now = m_clock.nsecsElapsed() / 1000;
+
+    /* keys are answered in order (text of later key cannot be filtered earlier) */
+    while ( m_pending < m_next && m_keys[m_pending].generation <= m_filtered ) {
+        Key &key = m_keys[m_pending];
+        key.latency = now - key.time;
+        traceCounter("Replay key to frame latency (ms)", key.latency / 1000);
+        ++m_pending;
+    }
+
+    if ( m_pending == m_keys.size() )
+        finish();
+}
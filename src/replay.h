@@ -0,0 +1,108 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QTimer>
+#include <QVector>
+
+class QLineEdit;
+class QWidget;
+
+/*
+ * Replays recorded keystrokes and measures latency from each key to the
+ * first frame that shows its result.
+ *
+ * Enabled if SPRINTER_REPLAY environment variable is set to a script
+ * file. Each line of the script contains time in milliseconds (since
+ * replay started) and key name (e.g. "a", "Space", "Backspace", "Down",
+ * "Ctrl+U"); empty lines and lines starting with "#" are ignored.
+ *
+ * Keys are sent to focused widget at given times. Frame is a repaint of
+ * the dialog window. If key changes text, only frames painted after the
+ * list is filtered with the new text are counted. Application quits
+ * after all keys are answered (or after a timeout) and latency
+ * percentiles are printed to standard error output or to file in
+ * SPRINTER_REPLAY_LOG.
+ */
+class Replay : public QObject
+{
+    Q_OBJECT
+public:
+    /* returns NULL if replay is not enabled, exits if script is invalid */
+    static Replay *fromEnvironment(QWidget *dialog);
+
+    Replay(QWidget *dialog, QObject *parent = NULL);
+
+    /* returns false if script cannot be loaded */
+    bool load(const QString &fileName);
+
+    void report(const QString &fileName = QString());
+
+    bool eventFilter(QObject *obj, QEvent *event);
+
+public slots:
+    void start();
+
+private slots:
+    void sendNextKey();
+    void textEdited();
+    void filterStarted();
+    void filterUpdated();
+    void finish();
+
+private:
+    struct Key {
+        /* time to send key (microseconds since start) */
+        qint64 time;
+        int key;
+        Qt::KeyboardModifiers modifiers;
+        QString text;
+        /* text generation after key was handled */
+        int generation;
+        /* latency in microseconds or -1 if no frame answered the key */
+        qint64 latency;
+    };
+
+    static bool parseKey(const QString &name, Key *key);
+    void frame();
+
+    QWidget *m_dialog;
+    QLineEdit *m_edit;
+    QVector<Key> m_keys;
+
+    /* next key to send */
+    int m_next;
+    /* first key not answered yet */
+    int m_pending;
+
+    /* text edits, text edits being filtered and already filtered */
+    int m_generation;
+    int m_requested;
+    int m_filtered;
+
+    QElapsedTimer m_clock;
+    QTimer m_timerKey;
+    QTimer m_timerFinish;
+};
+
+#endif // REPLAY_H
@@ -0,0 +1,192 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sharedinput.h"
+
+#include "trace.h"
+
+#include <QMetaObject>
+#include <QSocketNotifier>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#ifdef Q_OS_LINUX
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
+
+namespace {
+
+struct Header {
+    char magic[8];
+    quint64 end;
+    quint64 consumed;
+    quint32 closed;
+};
+
+} // namespace
+
+static const char shared_magic[8] = {'S', 'P', 'R', 'S', 'H', 'M', '1', '\0'};
+
+/* items start after header */
+static const quint64 shared_header_size = 64;
+
+/* bytes processed at once (rest is processed after pending events) */
+static const quint64 shared_batch_size = 1024 * 1024;
+
+static void printError(const QString &message)
+{
+    fprintf( stderr, "%s\n", message.toLocal8Bit().constData() );
+}
+
+SharedInput::SharedInput(QObject *parent)
+    : QObject(parent)
+    , m_data(NULL)
+    , m_size(0)
+    , m_offset(shared_header_size)
+    , m_eventFd(-1)
+    , m_notifier(NULL)
+{
+}
+
+SharedInput::~SharedInput()
+{
+    /* memory is not unmapped - items can still use it */
+    close();
+}
+
+bool SharedInput::open(int memoryFd, int eventFd)
+{
+#ifdef Q_OS_LINUX
+    struct stat st;
+    if ( fstat(memoryFd, &st) != 0 ) {
+        printError( tr("Cannot use shared memory: %1").arg(strerror(errno)) );
+        return false;
+    }
+
+    if ( static_cast<quint64>(st.st_size) < shared_header_size ) {
+        printError( tr("Unknown shared memory format!") );
+        return false;
+    }
+
+    void *data = mmap(NULL, st.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, memoryFd, 0);
+    if (data == MAP_FAILED) {
+        printError( tr("Cannot map shared memory: %1").arg(strerror(errno)) );
+        return false;
+    }
+    ::close(memoryFd);
+
+    if ( memcmp(data, shared_magic, sizeof(shared_magic)) != 0 ) {
+        printError( tr("Unknown shared memory format!") );
+        munmap(data, st.st_size);
+        return false;
+    }
+
+    m_data = static_cast<char *>(data);
+    m_size = st.st_size;
+
+    fcntl( eventFd, F_SETFL, fcntl(eventFd, F_GETFL) | O_NONBLOCK );
+    m_eventFd = eventFd;
+    m_notifier = new QSocketNotifier(eventFd, QSocketNotifier::Read, this);
+    connect( m_notifier, SIGNAL(activated(int)),
+             this, SLOT(readItems()) );
+
+    /* items can be already added */
+    QMetaObject::invokeMethod(this, "readItems", Qt::QueuedConnection);
+
+    return true;
+#else
+    Q_UNUSED(memoryFd);
+    Q_UNUSED(eventFd);
+    printError( tr("Shared memory input is not supported on this platform!") );
+    return false;
+#endif
+}
+
+void SharedInput::readItems()
+{
+#ifdef Q_OS_LINUX
+    if (!m_data)
+        return;
+
+    TRACE_SPAN("SharedInput::readItems");
+
+    /* reset event counter */
+    quint64 counter;
+    if ( m_eventFd != -1 && read(m_eventFd, &counter, sizeof(counter)) == -1
+         && errno != EAGAIN && errno != EINTR )
+    {
+        printError( tr("Error reading shared memory event: %1").arg(strerror(errno)) );
+    }
+
+    Header *header = reinterpret_cast<Header *>(m_data);
+
+    /* items are complete if producer finished before end was read */
+    const bool closed = __atomic_load_n(&header->closed, __ATOMIC_ACQUIRE) != 0;
+    const quint64 end = qMin( __atomic_load_n(&header->end, __ATOMIC_ACQUIRE), m_size );
+    const quint64 batchEnd = qMin(end, m_offset + shared_batch_size);
+
+    QVector<Item> items;
+    while ( m_offset < batchEnd && end - m_offset >= sizeof(quint32) ) {
+        quint32 size;
+        memcpy( &size, m_data + m_offset, sizeof(size) );
+        const quint64 start = m_offset + sizeof(size);
+        if (size > end - start) {
+            printError( tr("Invalid item in shared memory!") );
+            m_offset = end;
+            break;
+        }
+
+        items.append( Item::fromRawData(m_data + start, size) );
+        m_offset = start + size;
+    }
+
+    __atomic_store_n(&header->consumed, m_offset, __ATOMIC_RELEASE);
+
+    if ( !items.isEmpty() )
+        emit itemsRead(items);
+
+    /* continue after pending events are processed */
+    if (m_offset >= batchEnd && m_offset < end)
+        QMetaObject::invokeMethod(this, "readItems", Qt::QueuedConnection);
+    else if (closed)
+        close();
+#endif
+}
+
+void SharedInput::close()
+{
+#ifdef Q_OS_LINUX
+    /* can be called from notifier's signal */
+    if (m_notifier) {
+        m_notifier->setEnabled(false);
+        m_notifier->deleteLater();
+        m_notifier = NULL;
+    }
+
+    if (m_eventFd != -1) {
+        ::close(m_eventFd);
+        m_eventFd = -1;
+    }
+#endif
+}
@@ -0,0 +1,75 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SHAREDINPUT_H
+#define SHAREDINPUT_H
+
+#include "item.h"
+
+#include <QObject>
+#include <QVector>
+
+class QSocketNotifier;
+
+/*
+ * Reads items from memory shared with producer process (Linux only).
+ *
+ * Producer creates memory file (memfd) of fixed size and event counter
+ * (eventfd) and passes both descriptors to sprinter. Items are only
+ * appended to the memory and never moved or overwritten, so they are
+ * used in place without copying.
+ *
+ * Memory layout (integers are in native byte order):
+ *
+ *   offset  0: magic "SPRSHM1\0"
+ *   offset  8: 64-bit end of last complete item (updated by producer)
+ *   offset 16: 64-bit end of last item read by sprinter
+ *   offset 24: 32-bit flag set by producer after all items are added
+ *   offset 64: items - 32-bit length followed by item bytes
+ *
+ * After adding items, producer stores new end (with release semantics)
+ * and writes to event counter.
+ */
+class SharedInput : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SharedInput(QObject *parent = NULL);
+    ~SharedInput();
+
+    /* returns false if memory cannot be used */
+    bool open(int memoryFd, int eventFd);
+
+signals:
+    void itemsRead(const QVector<Item> &items);
+
+private slots:
+    void readItems();
+
+private:
+    void close();
+
+    char *m_data;
+    quint64 m_size;
+    quint64 m_offset;
+    int m_eventFd;
+    QSocketNotifier *m_notifier;
+};
+
+#endif // SHAREDINPUT_H
@@ -0,0 +1,252 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "sourcereader.h"
+
+#include "trace.h"
+
+#include <QFile>
+#include <QRunnable>
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+/* read sources in chunks */
+static const int source_chunk_size = 64 * 1024;
+
+/* check for cancellation while waiting for data */
+static const int source_poll_ms = 100;
+
+class ReadTask : public QRunnable
+{
+public:
+    ReadTask(SourceReader *reader, int source)
+        : m_reader(reader)
+        , m_source(source)
+    {
+    }
+
+    void run()
+    {
+        m_reader->read(m_source);
+    }
+
+private:
+    SourceReader *m_reader;
+    int m_source;
+};
+
+/* append complete lines prefixed with tag, keep incomplete last line */
+static void appendLines(const QByteArray &tag, const char *data, int size,
+                        QByteArray *line, QByteArray *lines)
+{
+    const char *end = data + size;
+
+    while (data < end) {
+        const char *eol = static_cast<const char *>( memchr(data, '\n', end - data) );
+        if (!eol) {
+            line->append(data, end - data);
+            return;
+        }
+
+        lines->append(tag).append(*line).append(data, eol - data + 1);
+        line->clear();
+        data = eol + 1;
+    }
+}
+
+SourceReader::SourceReader(QObject *parent)
+    : QObject(parent)
+    , m_tagItems(false)
+    , m_delimiter('\t')
+{
+    connect( &m_found, SIGNAL(linesAdded(QByteArray)),
+             this, SIGNAL(itemsRead(QByteArray)) );
+}
+
+SourceReader::~SourceReader()
+{
+    stop();
+}
+
+void SourceReader::addCommand(const QString &command)
+{
+    Source source = { command, true, -1, -1 };
+    m_sources.append(source);
+}
+
+void SourceReader::addFile(const QString &fileName)
+{
+    Source source = { fileName, false, -1, -1 };
+    m_sources.append(source);
+}
+
+void SourceReader::start()
+{
+    if ( m_cancel.loadAcquire() )
+        return;
+
+    /* all sources are read at the same time */
+    m_pool.setMaxThreadCount( qMax(1, m_sources.size()) );
+
+    for (int i = 0; i < m_sources.size(); ++i)
+        open(&m_sources[i]);
+
+    for (int i = 0; i < m_sources.size(); ++i) {
+        if (m_sources[i].fd != -1)
+            m_pool.start( new ReadTask(this, i) );
+    }
+}
+
+void SourceReader::stop()
+{
+    /* cancel */
+    m_cancel.storeRelease(1);
+    m_pool.waitForDone();
+
+    /* stop commands which haven't finished (including their children) */
+    for (int i = 0; i < m_sources.size(); ++i) {
+        Source &source = m_sources[i];
+        if (source.pid > 0) {
+            kill(-source.pid, SIGTERM);
+            source.pid = -1;
+        }
+    }
+}
+
+void SourceReader::read(int source)
+{
+    TRACE_SPAN("SourceReader::read");
+
+    /* sources are not added or removed while reading */
+    Source &s = m_sources[source];
+    const QByteArray prefix = tag(s);
+
+    char buffer[source_chunk_size];
+    QByteArray line;
+    struct pollfd fds;
+    fds.fd = s.fd;
+    fds.events = POLLIN;
+
+    while ( !m_cancel.loadAcquire() ) {
+        const int ready = poll(&fds, 1, source_poll_ms);
+        if (ready == 0 || (ready < 0 && errno == EINTR))
+            continue;
+
+        const ssize_t size = ready > 0 ? ::read( s.fd, buffer, sizeof(buffer) ) : -1;
+        if (size == 0)
+            break;
+
+        if (size < 0) {
+            if (errno == EINTR || errno == EAGAIN)
+                continue;
+            perror( QString("%1: %2").arg(tr("Error reading"), s.name).toLocal8Bit().constData() );
+            break;
+        }
+
+        QByteArray lines;
+        appendLines(prefix, buffer, size, &line, &lines);
+        addItems(lines);
+    }
+
+    /* last line can end without new line */
+    if ( !line.isEmpty() && !m_cancel.loadAcquire() )
+        addItems(prefix + line + '\n');
+
+    if (s.fd != STDIN_FILENO)
+        close(s.fd);
+
+    /* finished command must not be stopped (process group id can be reused) */
+    if ( s.pid > 0 && !m_cancel.loadAcquire() ) {
+        waitpid(s.pid, NULL, 0);
+        s.pid = -1;
+    }
+}
+
+bool SourceReader::open(Source *source)
+{
+    if (!source->command) {
+        if (source->name == "-") {
+            source->fd = STDIN_FILENO;
+        } else {
+            source->fd = ::open( QFile::encodeName(source->name).constData(), O_RDONLY | O_CLOEXEC );
+            if (source->fd == -1)
+                perror( QString("%1: %2").arg(tr("Cannot open file"), source->name).toLocal8Bit().constData() );
+        }
+        return source->fd != -1;
+    }
+
+    /* encode before forking */
+    const QByteArray command = source->name.toLocal8Bit();
+
+    int fds[2];
+    if ( pipe2(fds, O_CLOEXEC) != 0 ) {
+        perror( tr("Cannot create pipe").toLocal8Bit().constData() );
+        return false;
+    }
+
+    const pid_t pid = fork();
+    if (pid == -1) {
+        perror( tr("Cannot run command").toLocal8Bit().constData() );
+        close(fds[0]);
+        close(fds[1]);
+        return false;
+    }
+
+    if (pid == 0) {
+        /* own process group so the command can be stopped with its children */
+        setpgid(0, 0);
+
+        dup2(fds[1], STDOUT_FILENO);
+        const int input = ::open("/dev/null", O_RDONLY);
+        if (input != -1)
+            dup2(input, STDIN_FILENO);
+
+        execl("/bin/sh", "sh", "-c", command.constData(), static_cast<char *>(NULL));
+        _exit(127);
+    }
+
+    close(fds[1]);
+    source->fd = fds[0];
+    source->pid = pid;
+    return true;
+}
+
+QByteArray SourceReader::tag(const Source &source) const
+{
+    if (!m_tagItems)
+        return QByteArray();
+
+    /* tag must be single field */
+    QByteArray name = source.name.toUtf8();
+    name.replace(m_delimiter, ' ').replace('\n', ' ');
+    return name + m_delimiter;
+}
+
+void SourceReader::addItems(const QByteArray &lines)
+{
+    if ( !m_cancel.loadAcquire() )
+        m_found.append(lines);
+}
@@ -0,0 +1,93 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef SOURCEREADER_H
+#define SOURCEREADER_H
+
+#include "linequeue.h"
+
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QObject>
+#include <QThreadPool>
+#include <QVector>
+
+/*
+ * Reads items from multiple commands and files concurrently (one pool
+ * thread per source).
+ *
+ * Complete lines are emitted as soon as they are read so items from fast
+ * sources are not delayed by slow ones. Each item can be prefixed with
+ * name of its source followed by field delimiter.
+ */
+class SourceReader : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SourceReader(QObject *parent = NULL);
+    ~SourceReader();
+
+    /* read standard output of shell command */
+    void addCommand(const QString &command);
+
+    /* read file ("-" for stdin) */
+    void addFile(const QString &fileName);
+
+    /* prefix items with source name and delimiter */
+    void setTagItems(bool enable) { m_tagItems = enable; }
+    void setDelimiter(char delimiter) { m_delimiter = delimiter; }
+
+    /* called from pool threads */
+    void read(int source);
+
+public slots:
+    /* sources cannot be added after start */
+    void start();
+
+    /* stop reading and terminate commands (also done on destruction) */
+    void stop();
+
+signals:
+    /* new line separated items */
+    void itemsRead(const QByteArray &lines);
+
+private:
+    struct Source {
+        QString name;
+        bool command;
+        int fd;
+        int pid;
+    };
+
+    bool open(Source *source);
+    QByteArray tag(const Source &source) const;
+    void addItems(const QByteArray &lines);
+
+    QThreadPool m_pool;
+    QVector<Source> m_sources;
+    bool m_tagItems;
+    char m_delimiter;
+
+    QAtomicInt m_cancel;
+
+    /* items read but not yet emitted */
+    LineQueue m_found;
+};
+
+#endif // SOURCEREADER_H
@@ -0,0 +1,212 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "trace.h"
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QList>
+#include <QMutex>
+#include <QSharedPointer>
+#include <QThread>
+#include <QThreadStorage>
+
+#include <cstdio>
+
+/* maximum number of spans recorded per thread */
+static const int trace_buffer_size = 256 * 1024;
+
+struct TraceEvent {
+    const char *name;
+    qint64 start;
+    /* -1 for counter */
+    qint64 duration;
+    qint64 value;
+};
+
+/*
+ * Spans recorded in single thread. Only the owner thread appends spans
+ * and publishes new size, so no locking is needed.
+ */
+struct TraceBuffer {
+    explicit TraceBuffer(int id)
+        : id(id)
+        , dropped(0)
+        , events(new TraceEvent[trace_buffer_size])
+    {
+    }
+
+    ~TraceBuffer() { delete[] events; }
+
+    const int id;
+    QAtomicInt size;
+    int dropped;
+    TraceEvent *events;
+};
+
+typedef QSharedPointer<TraceBuffer> TraceBufferPtr;
+
+int trace_flags = 0;
+
+static QByteArray trace_file;
+static QElapsedTimer trace_timer;
+
+static Qt::HANDLE trace_gui_thread = NULL;
+static QAtomicPointer<const char> trace_gui_section;
+
+/* buffers are kept after threads exit */
+static QMutex trace_mutex;
+static QList<TraceBufferPtr> trace_buffers;
+static QThreadStorage<TraceBufferPtr> trace_local_buffer;
+
+static TraceBuffer *localBuffer()
+{
+    if ( !trace_local_buffer.hasLocalData() ) {
+        QMutexLocker lock(&trace_mutex);
+        TraceBufferPtr buffer( new TraceBuffer(trace_buffers.size() + 1) );
+        trace_buffers.append(buffer);
+        trace_local_buffer.setLocalData(buffer);
+    }
+
+    return trace_local_buffer.localData().data();
+}
+
+static void appendEvent(const char *name, qint64 start, qint64 duration, qint64 value)
+{
+    TraceBuffer *buffer = localBuffer();
+
+    const int i = buffer->size.loadAcquire();
+    if (i == trace_buffer_size) {
+        ++buffer->dropped;
+        return;
+    }
+
+    TraceEvent &event = buffer->events[i];
+    event.name = name;
+    event.start = start;
+    event.duration = duration;
+    event.value = value;
+    buffer->size.storeRelease(i + 1);
+}
+
+void traceInit()
+{
+    trace_gui_thread = QThread::currentThreadId();
+    trace_timer.start();
+
+    trace_file = qgetenv("SPRINTER_TRACE");
+    if ( !trace_file.isEmpty() )
+        trace_flags |= TraceRecord;
+}
+
+void traceEnableSections()
+{
+    trace_flags |= TraceSections;
+}
+
+qint64 traceTime()
+{
+    return trace_timer.nsecsElapsed() / 1000;
+}
+
+void traceCounter(const char *name, qint64 value)
+{
+    if (trace_flags & TraceRecord)
+        appendEvent(name, traceTime(), -1, value);
+}
+
+const char *traceGuiSection()
+{
+    return trace_gui_section.loadAcquire();
+}
+
+void TraceSpan::begin()
+{
+    if (trace_flags & TraceRecord)
+        m_start = traceTime();
+
+    if ( (trace_flags & TraceSections) && QThread::currentThreadId() == trace_gui_thread ) {
+        m_previous = trace_gui_section.fetchAndStoreOrdered(m_name);
+        m_section = true;
+    }
+}
+
+void TraceSpan::end()
+{
+    if (m_section)
+        trace_gui_section.storeRelease(m_previous);
+
+    if (m_start != -1)
+        appendEvent(m_name, m_start, traceTime() - m_start, 0);
+}
+
+void traceWrite()
+{
+    if ( !(trace_flags & TraceRecord) )
+        return;
+
+    QFile file( QString::fromLocal8Bit(trace_file) );
+    if ( !file.open(QIODevice::WriteOnly) ) {
+        fprintf( stderr, "%s\n", QObject::tr("Cannot write trace file \"%1\"!")
+                 .arg(file.fileName()).toLocal8Bit().constData() );
+        return;
+    }
+
+    const QByteArray pid = QByteArray::number( QCoreApplication::applicationPid() );
+    QByteArray out = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    bool first = true;
+
+    QMutexLocker lock(&trace_mutex);
+    foreach (const TraceBufferPtr &buffer, trace_buffers) {
+        const QByteArray tid = QByteArray::number(buffer->id);
+        const int size = buffer->size.loadAcquire();
+
+        for (int i = 0; i < size; ++i) {
+            const TraceEvent &event = buffer->events[i];
+            if (!first)
+                out.append(",\n");
+            first = false;
+
+            out.append("{\"name\":\"").append(event.name);
+            if (event.duration == -1) {
+                out.append("\",\"ph\":\"C\",\"ts\":").append( QByteArray::number(event.start) )
+                   .append(",\"args\":{\"value\":").append( QByteArray::number(event.value) )
+                   .append("}");
+            } else {
+                out.append("\",\"ph\":\"X\",\"ts\":").append( QByteArray::number(event.start) )
+                   .append(",\"dur\":").append( QByteArray::number(event.duration) );
+            }
+            out.append(",\"pid\":").append(pid)
+               .append(",\"tid\":").append(tid)
+               .append("}");
+        }
+        file.write(out);
+        out.clear();
+
+        if (buffer->dropped > 0) {
+            fprintf( stderr, "%s\n", QObject::tr("Trace buffer full, %1 spans dropped.")
+                     .arg(buffer->dropped).toLocal8Bit().constData() );
+        }
+    }
+
+    file.write("\n]}\n");
+}
@@ -0,0 +1,97 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <QtGlobal>
+
+/*
+ * Time spans recorded for performance analysis.
+ *
+ * Tracing is enabled if SPRINTER_TRACE environment variable is set to
+ * a file name. Spans are written to the file on exit in Chrome trace
+ * event format (can be loaded in chrome://tracing or ui.perfetto.dev).
+ *
+ * Spans also track innermost active section in GUI thread (used to find
+ * out what blocks event loop). If both are disabled, span costs only
+ * a single flag check.
+ */
+
+enum TraceFlag {
+    /* record spans for trace file */
+    TraceRecord = 1,
+    /* track active section in GUI thread */
+    TraceSections = 2
+};
+
+extern int trace_flags;
+
+/* call from GUI thread */
+void traceInit();
+void traceEnableSections();
+void traceWrite();
+
+/* microseconds since tracing started */
+qint64 traceTime();
+
+/* record current value of a counter (shown as graph in trace viewer) */
+void traceCounter(const char *name, qint64 value);
+
+/* innermost span active in GUI thread or NULL (can be called from any thread) */
+const char *traceGuiSection();
+
+class TraceSpan
+{
+public:
+    explicit TraceSpan(const char *name)
+        : m_name(name)
+        , m_start(-1)
+        , m_previous(NULL)
+        , m_section(false)
+    {
+        if (trace_flags)
+            begin();
+    }
+
+    ~TraceSpan()
+    {
+        if (trace_flags)
+            end();
+    }
+
+private:
+    Q_DISABLE_COPY(TraceSpan)
+
+    void begin();
+    void end();
+
+    const char *m_name;
+    qint64 m_start;
+    const char *m_previous;
+    bool m_section;
+};
+
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+
+/* record time spent until end of current scope */
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name)
+
+#endif // TRACE_H
@@ -0,0 +1,144 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "watchdog.h"
+
+#include "trace.h"
+
+#include <QFile>
+#include <QTextStream>
+
+#include <cstdio>
+
+static const int histogram_size = 8;
+
+Watchdog *Watchdog::fromEnvironment(QObject *parent)
+{
+    bool ok;
+    const int threshold = qgetenv("SPRINTER_WATCHDOG").toInt(&ok);
+    if (!ok || threshold <= 0)
+        return NULL;
+
+    Watchdog *watchdog = new Watchdog(threshold, parent);
+    watchdog->start(QThread::HighPriority);
+    return watchdog;
+}
+
+Watchdog::Watchdog(int threshold, QObject *parent)
+    : QThread(parent)
+    , m_threshold(threshold)
+    , m_interval( qMax(1, threshold / 4) )
+    , m_histogram(histogram_size, 0)
+{
+    traceEnableSections();
+
+    m_clock.start();
+    m_lastBeat.storeRelease(0);
+
+    /* heartbeat from GUI thread */
+    m_timer.setInterval(m_interval);
+    connect( &m_timer, SIGNAL(timeout()), this, SLOT(heartbeat()) );
+    m_timer.start();
+}
+
+Watchdog::~Watchdog()
+{
+    stop();
+}
+
+int Watchdog::elapsed() const
+{
+    return static_cast<int>( m_clock.elapsed() );
+}
+
+void Watchdog::stop()
+{
+    m_timer.stop();
+    m_stop.storeRelease(1);
+    wait();
+}
+
+void Watchdog::run()
+{
+    while ( !m_stop.loadAcquire() ) {
+        msleep(m_interval);
+
+        /* sample active section once per stall */
+        const int blocked = elapsed() - m_lastBeat.loadAcquire() - m_interval;
+        if ( blocked > m_threshold && m_stallSection.loadAcquire() == NULL ) {
+            const char *section = traceGuiSection();
+            m_stallSection.testAndSetOrdered(NULL, section ? section : "(event loop)");
+        }
+    }
+}
+
+void Watchdog::heartbeat()
+{
+    const int now = elapsed();
+    const int stall = now - m_lastBeat.loadAcquire() - m_interval;
+    m_lastBeat.storeRelease(now);
+
+    const char *section = m_stallSection.fetchAndStoreOrdered(NULL);
+    if (stall <= m_threshold)
+        return;
+
+    int i = 0;
+    while ( i + 1 < histogram_size && stall >= (m_threshold << (i + 1)) )
+        ++i;
+    ++m_histogram[i];
+
+    SectionStats &stats = m_sections[ section ? section : "(unknown)" ];
+    ++stats.count;
+    stats.total += stall;
+    stats.max = qMax(stats.max, stall);
+}
+
+void Watchdog::report(const QString &fileName)
+{
+    stop();
+
+    QFile file(fileName);
+    if ( fileName.isEmpty() || !file.open(QIODevice::WriteOnly) )
+        file.open(stderr, QIODevice::WriteOnly);
+
+    QTextStream out(&file);
+
+    int count = 0;
+    foreach (int n, m_histogram)
+        count += n;
+    out << tr("Event loop stalls longer than %1 ms: %2").arg(m_threshold).arg(count) << "\n";
+    if (count == 0)
+        return;
+
+    for (int i = 0; i < histogram_size; ++i) {
+        const QString range = i + 1 < histogram_size
+                ? QString("%1-%2 ms").arg(m_threshold << i).arg(m_threshold << (i + 1))
+                : QString(">%1 ms").arg(m_threshold << i);
+        out << "  " << range.leftJustified(16) << m_histogram[i] << "\n";
+    }
+
+    out << tr("Active section during stalls (count, total ms, max ms):") << "\n";
+    for ( QMap<QByteArray, SectionStats>::const_iterator it = m_sections.constBegin();
+          it != m_sections.constEnd(); ++it )
+    {
+        const SectionStats &stats = it.value();
+        out << "  " << QString::fromLatin1(it.key()).leftJustified(40)
+            << " " << stats.count << " " << stats.total << " " << stats.max << "\n";
+    }
+}
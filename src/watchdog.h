@@ -0,0 +1,85 @@
+/*
+    Copyright (c) 2014, Lukas Holecek <hluk@email.cz>
+
+    This file is part of Sprinter.
+
+    Sprinter is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    Sprinter is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with Sprinter.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#ifndef WATCHDOG_H
+#define WATCHDOG_H
+
+#include <QAtomicInt>
+#include <QAtomicPointer>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QThread>
+#include <QTimer>
+#include <QVector>
+
+/*
+ * Detects stalls of GUI event loop.
+ *
+ * Enabled if SPRINTER_WATCHDOG environment variable is set to stall
+ * threshold in milliseconds. Timer in GUI thread updates heartbeat and
+ * watchdog thread checks it periodically; if event loop is blocked, name
+ * of active span (see trace.h) is sampled. Histogram of stalls is printed
+ * on exit to standard error output or to file in SPRINTER_WATCHDOG_LOG.
+ */
+class Watchdog : public QThread
+{
+    Q_OBJECT
+public:
+    /* returns NULL if watchdog is not enabled */
+    static Watchdog *fromEnvironment(QObject *parent = NULL);
+
+    explicit Watchdog(int threshold, QObject *parent = NULL);
+    ~Watchdog();
+
+    /* stops watchdog and prints stall histogram */
+    void report(const QString &fileName = QString());
+
+protected:
+    void run();
+
+private slots:
+    void heartbeat();
+
+private:
+    struct SectionStats {
+        SectionStats() : count(0), total(0), max(0) {}
+        int count;
+        qint64 total;
+        int max;
+    };
+
+    void stop();
+    int elapsed() const;
+
+    int m_threshold;
+    int m_interval;
+    QElapsedTimer m_clock;
+    QTimer m_timer;
+    QAtomicInt m_lastBeat;
+    QAtomicInt m_stop;
+    /* section sampled during current stall */
+    QAtomicPointer<const char> m_stallSection;
+
+    /* stall count for durations [threshold * 2^i, threshold * 2^(i+1)) */
+    QVector<int> m_histogram;
+    QMap<QByteArray, SectionStats> m_sections;
+};
+
+#endif // WATCHDOG_H